@@ -37,6 +37,10 @@
 /**                                                                        **/
 /** Falls bei Aufruf von AskParams() argc < 2 "ubergeben wird, werden      **/
 /** die Parameter statt dessen von der Standardeingabe gelesen.            **/
+/**                                                                        **/
+/** R"uckgabe: PARAMS_OK, PARAMS_USAGE (Hilfe ausgegeben) oder             **/
+/** PARAMS_INVALID (ung"ultiger Parameter). AskParams beendet das Programm **/
+/** nicht selbst, damit partdiff-par alle Prozesse sauber beenden kann.    **/
 /****************************************************************************/
 /** int *method;                                                           **/
 /**         Bezeichnet das bei der L"osung der Poissongleichung zu         **/
@@ -50,7 +54,7 @@
 /**         Problemgr"o"se (auf dem Aufgabenblatt mit N bezeichnet)        **/
 /**         wird benutzt, um mittels der Ausgaberoutine DisplayMatrix()    **/
 /**         immer eine "ubersichtliche Ausgabe zu erhalten.                **/
-/** Werte:  0 < *interlines                                                **/
+/** Werte:  0 <= *interlines <= MAX_INTERLINES                             **/
 /****************************************************************************/
 /** int *func:                                                             **/
 /**         Bezeichnet die St"orfunktion ( I oder II ) und damit auch      **/
@@ -76,7 +80,7 @@
 #include "partdiff-seq.h"
 #include <string.h>
 
-void AskParams(struct options* options, int argc, char** argv)
+int AskParams(struct options* options, int argc, char** argv)
 {
     printf("\n");
     printf("============================================================\n");
@@ -110,10 +114,11 @@ void AskParams(struct options* options, int argc, char** argv)
         do {
             printf("\n");
             printf("Matrixsize = Interlines*8+9\n");
+            printf("  Range: 0 .. %d.\n", MAX_INTERLINES);
             printf("Interlines> ");
             fflush(stdout);
             scanf("%d", &(options->interlines));
-        } while ((options->interlines < 0) || (options->interlines > 1000));
+        } while ((options->interlines < 0) || (options->interlines > MAX_INTERLINES));
         do {
             printf("\n");
             printf("Select interference function:\n");
@@ -165,6 +170,7 @@ void AskParams(struct options* options, int argc, char** argv)
             printf("  - method: %1d: Gauss-Seidel.\n", METH_GAUSS_SEIDEL);
             printf("            %1d: Jacobi.\n", METH_JACOBI);
             printf("  - lines:  (lines=interlines) matrixsize = interlines*8+9\n");
+            printf("            Range: 0 .. %d.\n", MAX_INTERLINES);
             printf("  - func:   %1d: f(x,y)=0.\n", FUNC_F0);
             printf("            %1d: f(x,y)=2pi^2*sin(pi*x)sin(pi*y).\n", FUNC_FPISIN);
             printf("  - term:   %1d: sufficient precision.\n", TERM_PREC);
@@ -173,8 +179,16 @@ void AskParams(struct options* options, int argc, char** argv)
             printf("            precision:  Range: 1e-4 .. 1e-20.\n");
             printf("            iterations: Range: 1 .. %d.\n", MAX_ITERATION);
             printf("\n");
+            printf("Environment:\n");
+            printf("  - PARTDIFF_HUGEPAGES: %1d: off.\n", HUGE_PAGES_OFF);
+            printf("            %1d: transparent huge pages (default).\n", HUGE_PAGES_TRANSPARENT);
+            printf("            %1d: reserved huge pages (MAP_HUGETLB).\n", HUGE_PAGES_EXPLICIT);
+            printf("  - PARTDIFF_OVERLAP: 0: off (default).\n");
+            printf("            1: partdiff-par, Jacobi: update the inner rows and columns\n");
+            printf("               while the ghost rows and columns are exchanged.\n");
+            printf("\n");
             printf("Example: %s 1 2 100 1 2 100 \n", argv[0]);
-            exit(0);
+            return PARAMS_USAGE;
         }
 
         sscanf(argv[1], "%d", &(options->number));
@@ -190,5 +204,66 @@ void AskParams(struct options* options, int argc, char** argv)
             sscanf(argv[6], "%d", &(options->term_iteration));
             options->term_precision = 0;
         }
+
+        if (!CheckParams(options)) {
+            printf("Ungueltige Parameter, siehe: %s help\n", argv[0]);
+            return PARAMS_INVALID;
+        }
+    }
+
+    /* huge pages for the matrices are not part of the command line */
+    options->huge_pages = HUGE_PAGES_TRANSPARENT;
+
+    if (getenv("PARTDIFF_HUGEPAGES") != NULL) {
+        sscanf(getenv("PARTDIFF_HUGEPAGES"), "%d", &(options->huge_pages));
+
+        if (options->huge_pages < HUGE_PAGES_OFF || options->huge_pages > HUGE_PAGES_EXPLICIT) {
+            printf("PARTDIFF_HUGEPAGES: %1d, %1d or %1d\n", HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT,
+                HUGE_PAGES_EXPLICIT);
+            return PARAMS_INVALID;
+        }
+    }
+
+    options->overlap = 0;
+
+    if (getenv("PARTDIFF_OVERLAP") != NULL) {
+        sscanf(getenv("PARTDIFF_OVERLAP"), "%d", &(options->overlap));
+
+        if (options->overlap < 0 || options->overlap > 1) {
+            printf("PARTDIFF_OVERLAP: 0 or 1\n");
+            return PARAMS_INVALID;
+        }
     }
+
+    return PARAMS_OK;
+}
+
+/* checks the ranges the interactive input above enforces: number >= 0,     */
+/* a known method, 0 <= interlines <= MAX_INTERLINES, a known inference     */
+/* function and termination, precision 1e-20 .. 1e-4 or iterations          */
+/* 1 .. MAX_ITERATION. partdiff-par calls this on every process because     */
+/* only process 0 reads the command line.                                   */
+int CheckParams(struct options const* options)
+{
+    if (options->number < 0 || options->interlines < 0 || options->interlines > MAX_INTERLINES) {
+        return 0;
+    }
+
+    if (options->method < METH_GAUSS_SEIDEL || options->method > METH_JACOBI) {
+        return 0;
+    }
+
+    if (options->inf_func < FUNC_F0 || options->inf_func > FUNC_FPISIN) {
+        return 0;
+    }
+
+    if (options->termination == TERM_PREC) {
+        return options->term_precision >= 1e-20 && options->term_precision <= 1e-4;
+    }
+
+    if (options->termination == TERM_ITER) {
+        return options->term_iteration >= 1 && options->term_iteration <= MAX_ITERATION;
+    }
+
+    return 0;
 }
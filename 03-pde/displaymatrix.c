@@ -24,7 +24,7 @@
 /**                                                                        **/
 /** Die Funktion erwartet einen Zeiger auf ein lineares Feld, in dem       **/
 /** die Matrixeintraege wie in einer zweidimensionalen Matrix abgelegt     **/
-/** sind.                                                                  **/
+/** sind. Zwei Zeilen liegen stride Eintraege auseinander.                 **/
 /**                                                                        **/
 /****************************************************************************/
 
@@ -42,15 +42,14 @@
 #include "partdiff-seq.h"
 #include <stdio.h>
 
-void DisplayMatrix(char* s, double* v, int interlines)
+void DisplayMatrix(char* s, double* v, int interlines, int stride)
 {
     int x, y;
-    int lines = 8 * interlines + 9;
 
     printf("%s\n", s);
     for (y = 0; y < 9; y++) {
         for (x = 0; x < 9; x++) {
-            printf("%11.8f", v[y * (interlines + 1) * lines + x * (interlines + 1)]);
+            printf("%11.8f", v[y * (interlines + 1) * stride + x * (interlines + 1)]);
         }
         printf("\n");
     }
@@ -0,0 +1,930 @@
+/****************************************************************************/
+/****************************************************************************/
+/**                                                                        **/
+/**                TU München - Institut fuer Informatik                   **/
+/**                                                                        **/
+/** Copyright: Prof. Dr. Thomas Ludwig                                     **/
+/**            Andreas C. Schmidt                                          **/
+/**                                                                        **/
+/** File:      partdiff-par.c                                              **/
+/**                                                                        **/
+/** Purpose:   Partial differential equation solver for Gauss-Seidel and   **/
+/**            Jacobi methods, distributed with MPI.                       **/
+/**                                                                        **/
+/** The processes form a two-dimensional grid (MPI_Cart_create). Every     **/
+/** process holds only one block of the matrices plus a frame of ghost     **/
+/** rows and columns. The frame holds copies of the neighbours' border     **/
+/** rows and columns and is exchanged once per iteration. Compared to      **/
+/** bands of full rows, a block of P processes only exchanges about        **/
+/** 4 (N+1) / sqrt(P) instead of 2 (N+1) values per iteration.             **/
+/**                                                                        **/
+/** Gauss-Seidel runs as a pipeline: a process starts iteration t as soon  **/
+/** as the processes above and left of it have finished t and the ones     **/
+/** below and right of it have finished t - 1, so up to dims[0] + dims[1]  **/
+/** - 1 iterations are in flight along the diagonal of the process grid.   **/
+/** Every element sees the same values as in partdiff-seq.c.               **/
+/**                                                                        **/
+/** With PARTDIFF_OVERLAP=1, Jacobi starts the exchange of the ghost frame **/
+/** through persistent requests, updates the elements that do not need it  **/
+/** and only then waits for the exchange and updates the outer rows and    **/
+/** columns of the block.                                                  **/
+/**                                                                        **/
+/** Inside a process, options->number OpenMP threads share the block, so   **/
+/** one process per socket or node is enough (e.g. mpirun --map-by socket).**/
+/** Only the master thread calls MPI (MPI_THREAD_FUNNELED). Jacobi splits  **/
+/** the rows among the threads; with PARTDIFF_OVERLAP, the master thread   **/
+/** drives the exchange while the others start on the inner rows, and      **/
+/** joins them afterwards. Gauss-Seidel runs over tiles of the block along **/
+/** anti-diagonals, which keeps the order of the sequential loop.          **/
+/**                                                                        **/
+/****************************************************************************/
+/****************************************************************************/
+
+/* ************************************************************************ */
+/* Include standard header file.                                            */
+/* ************************************************************************ */
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, madvise() */
+
+#include "partdiff-seq.h"
+#include <malloc.h>
+#include <math.h>
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+/* edge length of the tiles of the Gauss-Seidel wavefront inside a block    */
+#define TILE_SIZE 64
+
+/* ************************************************************************ */
+/* A matrix is stored row by row in one flat block of memory; rows are      */
+/* padded to an odd number of cache lines against cache-set aliasing        */
+/* ************************************************************************ */
+struct grid {
+    double* data; /* local element (k, l) is data[k * stride + l]    */
+    int stride; /* distance between two rows in doubles            */
+};
+
+struct calculation_arguments {
+    int N; /* number of spaces between lines (lines=N+1)     */
+    int num_matrices; /* number of matrices                             */
+    struct grid* Matrix; /* the matrices, pointing into M                  */
+    double* M; /* memory of all matrices                         */
+    size_t M_size; /* bytes mapped for M                             */
+    double h; /* length of a space between two lines            */
+    double* sin_pih; /* sin(pi*h*k) per line (FUNC_FPISIN)             */
+
+    MPI_Comm comm; /* process grid taking part in the calculation    */
+    int rank; /* rank in comm                                   */
+    int size; /* number of processes in comm                    */
+    int dims[2]; /* processes per dimension (rows, columns)        */
+    int coords[2]; /* coordinates of this process in the grid        */
+    int from[2]; /* first row and column of this process           */
+    int to[2]; /* last row and column of this process            */
+    int lines; /* local rows plus two ghost rows                 */
+    int columns; /* local columns plus two ghost columns           */
+    int above, below; /* neighbours in dimension 0, or MPI_PROC_NULL    */
+    int left, right; /* neighbours in dimension 1, or MPI_PROC_NULL    */
+    MPI_Datatype column; /* the inner elements of one local column         */
+};
+
+struct calculation_results {
+    int m;
+    int stat_iteration; /* number of current iteration                    */
+    double stat_precision; /* actual precision of all slaves in iteration    */
+};
+
+/* ************************************************************************ */
+/* Global variables                                                         */
+/* ************************************************************************ */
+
+/* time measurement variables */
+struct timeval start_time; /* time when program started                      */
+struct timeval comp_time; /* time when calculation completed                */
+
+/* ************************************************************************ */
+/* distribute: the lines 1 .. n are split into parts ranges whose lengths   */
+/* differ by at most one; range index is [*from, *to]                       */
+/* ************************************************************************ */
+static void distribute(int n, int parts, int index, int* from, int* to)
+{
+    int share = n / parts;
+    int rest = n % parts;
+
+    *from = 1 + index * share + ((index < rest) ? index : rest);
+    *to = *from + share + ((index < rest) ? 1 : 0) - 1;
+}
+
+/* ************************************************************************ */
+/* owner: returns the index of the range of distribute() holding line g;    */
+/* the boundary lines 0 and n + 1 are ghosts of the first and last range    */
+/* ************************************************************************ */
+static int owner(int n, int parts, int g)
+{
+    int index, from, to;
+
+    for (index = 0; index < parts; index++) {
+        distribute(n, parts, index, &from, &to);
+
+        if (g <= to) {
+            return index;
+        }
+    }
+
+    return parts - 1;
+}
+
+/* ************************************************************************ */
+/* initVariables: Initializes some global variables                         */
+/* ************************************************************************ */
+static void initVariables(
+    struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+    arguments->N = options->interlines * 8 + 9 - 1;
+    arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
+    arguments->h = (float)(((float)(1)) / (arguments->N));
+    arguments->sin_pih = NULL;
+
+    MPI_Cart_coords(arguments->comm, arguments->rank, 2, arguments->coords);
+    MPI_Cart_shift(arguments->comm, 0, 1, &arguments->above, &arguments->below);
+    MPI_Cart_shift(arguments->comm, 1, 1, &arguments->left, &arguments->right);
+
+    for (int d = 0; d < 2; d++) {
+        distribute(arguments->N - 1, arguments->dims[d], arguments->coords[d], &arguments->from[d], &arguments->to[d]);
+    }
+
+    arguments->lines = arguments->to[0] - arguments->from[0] + 3;
+    arguments->columns = arguments->to[1] - arguments->from[1] + 3;
+
+    results->m = 0;
+    results->stat_iteration = 0;
+    results->stat_precision = 0;
+}
+
+/* ************************************************************************ */
+/* freeMatrices: frees memory for matrices                                  */
+/* ************************************************************************ */
+static void freeMatrices(struct calculation_arguments* arguments)
+{
+    free(arguments->Matrix);
+    munmap(arguments->M, arguments->M_size);
+    free(arguments->sin_pih);
+    MPI_Type_free(&arguments->column);
+}
+
+/* ************************************************************************ */
+/* allocateMemory ()                                                        */
+/* allocates memory and quits if there was a memory allocation problem      */
+/* ************************************************************************ */
+static void* allocateMemory(size_t size)
+{
+    void* p;
+
+    if ((p = malloc(size)) == NULL) {
+        printf("\n\nSpeicherprobleme!\n");
+        /* exit program */
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+/* ************************************************************************ */
+/* allocateGrid ()                                                          */
+/* maps page-aligned memory for matrices, backed by huge pages if wanted;   */
+/* *size is rounded up to the size actually mapped                          */
+/* ************************************************************************ */
+static void* allocateGrid(size_t* size, int huge_pages)
+{
+    void* p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (huge_pages == HUGE_PAGES_EXPLICIT) {
+        size_t rounded = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (p != MAP_FAILED) {
+            *size = rounded;
+            return p;
+        }
+    }
+#endif
+
+    p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED) {
+        printf("\n\nSpeicherprobleme!\n");
+        /* exit program */
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (huge_pages != HUGE_PAGES_OFF) {
+        /* only a hint, the matrices work without transparent huge pages */
+        (void)madvise(p, *size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return p;
+}
+
+/* ************************************************************************ */
+/* allocateMatrices: allocates memory for the local block of the matrices   */
+/* ************************************************************************ */
+static void allocateMatrices(struct calculation_arguments* arguments, struct options* options)
+{
+    int i;
+
+    int per_line = CACHE_LINE / sizeof(double);
+
+    /* round the rows up to an odd number of cache lines */
+    int cache_lines = (arguments->columns + per_line - 1) / per_line;
+    int stride = ((cache_lines % 2 == 0) ? cache_lines + 1 : cache_lines) * per_line;
+
+    /* one extra cache line keeps row i of two matrices in different sets */
+    size_t pitch = (size_t)arguments->lines * stride + per_line;
+
+    arguments->M_size = arguments->num_matrices * pitch * sizeof(double);
+    arguments->M = allocateGrid(&arguments->M_size, options->huge_pages);
+    arguments->Matrix = allocateMemory(arguments->num_matrices * sizeof(struct grid));
+
+    for (i = 0; i < arguments->num_matrices; i++) {
+        arguments->Matrix[i].data = arguments->M + i * pitch;
+        arguments->Matrix[i].stride = stride;
+    }
+
+    /* the inner rows of one column, for the ghost columns */
+    MPI_Type_vector(arguments->lines - 2, 1, stride, MPI_DOUBLE, &arguments->column);
+    MPI_Type_commit(&arguments->column);
+}
+
+/* ************************************************************************ */
+/* initMatrices: Initialize the local block of the matrix/matrices          */
+/* Local element (k, l) is global element (from[0] - 1 + k,                 */
+/* from[1] - 1 + l); the borders get the same values as in partdiff-seq.c   */
+/* ************************************************************************ */
+static void initMatrices(struct calculation_arguments* arguments, struct options* options)
+{
+    int g, i, j, k, l; /*  local variables for loops   */
+
+    int N = arguments->N;
+    double h = arguments->h;
+    struct grid* Matrix = arguments->Matrix;
+
+    for (g = 0; g < arguments->num_matrices; g++) {
+        int stride = Matrix[g].stride;
+
+        for (k = 0; k < arguments->lines; k++) {
+            double* row = Matrix[g].data + (size_t)k * stride;
+
+            i = arguments->from[0] - 1 + k;
+
+            for (l = 0; l < arguments->columns; l++) {
+                j = arguments->from[1] - 1 + l;
+
+                /* initialize matrix/matrices with zeros */
+                row[l] = 0;
+
+                /* initialize borders, depending on function (function 2: nothing to do) */
+                if (options->inf_func == FUNC_F0) {
+                    if (j == 0 && i < N) {
+                        row[l] = 3 + (1 - (h * i)); // Linke Kante
+                    } else if (j == N && i > 0) {
+                        row[l] = 2 + h * (N - i); // Rechte Kante
+                    } else if (i == 0 && j > 0) {
+                        row[l] = 3 + h * (N - j); // Obere Kante
+                    } else if (i == N && j < N) {
+                        row[l] = 3 - (h * j); // Untere Kante
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* ************************************************************************ */
+/* initSourceTerm: tabulates the inference function                         */
+/* f(x,y) = 2pi^2*sin(pi*x)sin(pi*y) is separable; sin(pi*h*k) is computed  */
+/* once per line instead of twice per element and iteration                 */
+/* ************************************************************************ */
+static void initSourceTerm(struct calculation_arguments* arguments, struct options* options)
+{
+    int k;
+
+    if (options->inf_func != FUNC_FPISIN) {
+        return;
+    }
+
+    arguments->sin_pih = allocateMemory((arguments->N + 1) * sizeof(double));
+
+    for (k = 0; k <= arguments->N; k++) {
+        arguments->sin_pih[k] = sin((double)(k)*PI * arguments->h);
+    }
+}
+
+/* ************************************************************************ */
+/* getResiduum: calculates residuum                                         */
+/* Input: x,y - actual row and column                                       */
+/*        sin_pih - table of initSourceTerm, NULL for FUNC_F0               */
+/* ************************************************************************ */
+static inline double getResiduum(double h, double const* sin_pih, int x, int y, double star)
+{
+    if (sin_pih == NULL) {
+        return ((-star) / 4.0);
+    } else {
+        return ((TWO_PI_SQUARE * sin_pih[y] * sin_pih[x] * h * h - star) / 4.0);
+    }
+}
+
+/* ************************************************************************ */
+/* exchangeGhosts: sends the outer rows and columns of the local block to   */
+/* the neighbours and receives theirs into the ghost frame of Matrix        */
+/* The corners of the frame are not needed by the five-point stencil; the   */
+/* boundary rows and columns 0 and N have no neighbour (MPI_PROC_NULL)      */
+/* ************************************************************************ */
+static void exchangeGhosts(struct calculation_arguments const* arguments, double* Matrix)
+{
+    int stride = arguments->Matrix[0].stride;
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    MPI_Comm comm = arguments->comm;
+
+    double* first_row = Matrix + stride + 1;
+    double* last_row = Matrix + (size_t)(lines - 2) * stride + 1;
+
+    /* rows are contiguous */
+    MPI_Sendrecv(first_row, columns - 2, MPI_DOUBLE, arguments->above, 0, last_row + stride, columns - 2, MPI_DOUBLE,
+        arguments->below, 0, comm, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(last_row, columns - 2, MPI_DOUBLE, arguments->below, 1, first_row - stride, columns - 2, MPI_DOUBLE,
+        arguments->above, 1, comm, MPI_STATUS_IGNORE);
+
+    /* columns are strided, see arguments->column */
+    MPI_Sendrecv(Matrix + stride + 1, 1, arguments->column, arguments->left, 2, Matrix + stride + columns - 1, 1,
+        arguments->column, arguments->right, 2, comm, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(Matrix + stride + columns - 2, 1, arguments->column, arguments->right, 3, Matrix + stride, 1,
+        arguments->column, arguments->left, 3, comm, MPI_STATUS_IGNORE);
+}
+
+/* ************************************************************************ */
+/* initGhosts: creates the persistent requests exchanging the ghost frame   */
+/* of Matrix; the same messages as exchangeGhosts                           */
+/* ************************************************************************ */
+static void initGhosts(struct calculation_arguments const* arguments, double* Matrix, MPI_Request* requests)
+{
+    int stride = arguments->Matrix[0].stride;
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    MPI_Comm comm = arguments->comm;
+
+    double* first_row = Matrix + stride + 1;
+    double* last_row = Matrix + (size_t)(lines - 2) * stride + 1;
+
+    MPI_Recv_init(first_row - stride, columns - 2, MPI_DOUBLE, arguments->above, 1, comm, &requests[0]);
+    MPI_Recv_init(last_row + stride, columns - 2, MPI_DOUBLE, arguments->below, 0, comm, &requests[1]);
+    MPI_Recv_init(Matrix + stride, 1, arguments->column, arguments->left, 3, comm, &requests[2]);
+    MPI_Recv_init(Matrix + stride + columns - 1, 1, arguments->column, arguments->right, 2, comm, &requests[3]);
+
+    MPI_Send_init(first_row, columns - 2, MPI_DOUBLE, arguments->above, 0, comm, &requests[4]);
+    MPI_Send_init(last_row, columns - 2, MPI_DOUBLE, arguments->below, 1, comm, &requests[5]);
+    MPI_Send_init(Matrix + stride + 1, 1, arguments->column, arguments->left, 2, comm, &requests[6]);
+    MPI_Send_init(Matrix + stride + columns - 2, 1, arguments->column, arguments->right, 3, comm, &requests[7]);
+}
+
+/* ************************************************************************ */
+/* receiveGhosts: Gauss-Seidel pipeline, before an iteration                */
+/* Receives the rows and columns of this iteration from above and left and, */
+/* except for the first iteration, those of the previous one from below and */
+/* right; then waits until the sends of the previous iteration are done     */
+/* ************************************************************************ */
+static void receiveGhosts(
+    struct calculation_arguments const* arguments, double* Matrix, int first, MPI_Request* sends)
+{
+    int stride = arguments->Matrix[0].stride;
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    MPI_Comm comm = arguments->comm;
+
+    double* first_row = Matrix + stride + 1;
+    double* last_row = Matrix + (size_t)(lines - 2) * stride + 1;
+
+    if (!first) {
+        MPI_Recv(last_row + stride, columns - 2, MPI_DOUBLE, arguments->below, 1, comm, MPI_STATUS_IGNORE);
+        MPI_Recv(Matrix + stride + columns - 1, 1, arguments->column, arguments->right, 3, comm, MPI_STATUS_IGNORE);
+    }
+
+    MPI_Recv(first_row - stride, columns - 2, MPI_DOUBLE, arguments->above, 0, comm, MPI_STATUS_IGNORE);
+    MPI_Recv(Matrix + stride, 1, arguments->column, arguments->left, 2, comm, MPI_STATUS_IGNORE);
+
+    /* the outer rows and columns are about to change */
+    MPI_Waitall(4, sends, MPI_STATUSES_IGNORE);
+}
+
+/* ************************************************************************ */
+/* sendBorders: Gauss-Seidel pipeline, after an iteration                   */
+/* Sends the new outer rows and columns to below and right, which need them */
+/* for the same iteration, and, except after the last iteration, to above   */
+/* and left, which need them for the next one                               */
+/* ************************************************************************ */
+static void sendBorders(struct calculation_arguments const* arguments, double* Matrix, int last, MPI_Request* sends)
+{
+    int stride = arguments->Matrix[0].stride;
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    MPI_Comm comm = arguments->comm;
+
+    double* first_row = Matrix + stride + 1;
+    double* last_row = Matrix + (size_t)(lines - 2) * stride + 1;
+
+    MPI_Isend(last_row, columns - 2, MPI_DOUBLE, arguments->below, 0, comm, &sends[0]);
+    MPI_Isend(Matrix + stride + columns - 2, 1, arguments->column, arguments->right, 2, comm, &sends[1]);
+
+    if (!last) {
+        MPI_Isend(first_row, columns - 2, MPI_DOUBLE, arguments->above, 1, comm, &sends[2]);
+        MPI_Isend(Matrix + stride + 1, 1, arguments->column, arguments->left, 3, comm, &sends[3]);
+    }
+}
+
+/* ************************************************************************ */
+/* calculateBlock: updates the local rows [i0, i1) and columns [j0, j1)     */
+/* Returns the maximum of maxResiduum and the residua of these elements     */
+/* ************************************************************************ */
+static double calculateBlock(struct calculation_arguments const* arguments, double* Matrix_Out,
+    double const* Matrix_In, int i0, int i1, int j0, int j1, double maxResiduum)
+{
+    int i, j; /* local variables for loops  */
+    double star; /* four times center value minus 4 neigh.b values */
+    double korrektur;
+    double residuum; /* residuum of current iteration                  */
+
+    int stride = arguments->Matrix[0].stride;
+    int row0 = arguments->from[0] - 1; /* global row of local row 0       */
+    int col0 = arguments->from[1] - 1; /* global column of local column 0 */
+    double h = arguments->h;
+    double const* sin_pih = arguments->sin_pih;
+
+    /* over the local rows */
+    for (i = i0; i < i1; i++) {
+        double const* above = Matrix_In + (size_t)(i - 1) * stride;
+        double const* row = Matrix_In + (size_t)i * stride;
+        double const* below = Matrix_In + (size_t)(i + 1) * stride;
+        double* out = Matrix_Out + (size_t)i * stride;
+
+        /* over the local columns */
+        for (j = j0; j < j1; j++) {
+            star = -above[j] - row[j - 1] - row[j + 1] - below[j] + 4.0 * row[j];
+
+            residuum = getResiduum(h, sin_pih, row0 + i, col0 + j, star);
+            korrektur = residuum;
+            residuum = (residuum < 0) ? -residuum : residuum;
+            maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+
+            out[j] = row[j] + korrektur;
+        }
+    }
+
+    return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculateOverlapped: Jacobi iteration hiding the exchange of the ghost   */
+/* frame of Matrix_In behind the elements that do not need it               */
+/* ************************************************************************ */
+static double calculateOverlapped(
+    struct calculation_arguments const* arguments, double* Matrix_Out, double const* Matrix_In, MPI_Request* halo)
+{
+    int i;
+    double maxResiduum = 0;
+
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    int last_row = lines - 2; /* local index of the last row    */
+    int last_column = columns - 2; /* local index of the last column */
+
+    MPI_Startall(8, halo);
+
+#pragma omp parallel reduction(max : maxResiduum)
+    {
+        /* with more than one thread, the master thread waits for the      */
+        /* exchange while the others start on the inner rows               */
+        if (omp_get_num_threads() > 1) {
+#pragma omp master
+            MPI_Waitall(8, halo, MPI_STATUSES_IGNORE);
+        }
+
+        /* the inner elements only read the block itself */
+#pragma omp for schedule(dynamic)
+        for (i = 2; i < last_row; i++) {
+            maxResiduum = calculateBlock(arguments, Matrix_Out, Matrix_In, i, i + 1, 2, last_column, maxResiduum);
+        }
+
+#pragma omp master
+        MPI_Waitall(8, halo, MPI_STATUSES_IGNORE);
+
+#pragma omp barrier
+
+        /* the first and the last row, then the first and the last column  */
+        /* in between; a single row or column is updated once              */
+#pragma omp for schedule(static, 1)
+        for (i = 0; i < 4; i++) {
+            if (i == 0) {
+                maxResiduum = calculateBlock(arguments, Matrix_Out, Matrix_In, 1, 2, 1, columns - 1, maxResiduum);
+            } else if (i == 1 && last_row > 1) {
+                maxResiduum = calculateBlock(
+                    arguments, Matrix_Out, Matrix_In, last_row, last_row + 1, 1, columns - 1, maxResiduum);
+            } else if (i == 2) {
+                maxResiduum = calculateBlock(arguments, Matrix_Out, Matrix_In, 2, last_row, 1, 2, maxResiduum);
+            } else if (i == 3 && last_column > 1) {
+                maxResiduum = calculateBlock(
+                    arguments, Matrix_Out, Matrix_In, 2, last_row, last_column, last_column + 1, maxResiduum);
+            }
+        }
+    }
+
+    return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculateRows: Jacobi iteration, the rows are split among the threads    */
+/* ************************************************************************ */
+static double calculateRows(
+    struct calculation_arguments const* arguments, double* Matrix_Out, double const* Matrix_In)
+{
+    int i;
+    double maxResiduum = 0;
+
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+
+#pragma omp parallel for schedule(static) reduction(max : maxResiduum)
+    for (i = 1; i < lines - 1; i++) {
+        maxResiduum = calculateBlock(arguments, Matrix_Out, Matrix_In, i, i + 1, 1, columns - 1, maxResiduum);
+    }
+
+    return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculateWavefront: Gauss-Seidel iteration on the threads                */
+/* The block is cut into tiles of TILE_SIZE x TILE_SIZE elements. Tile      */
+/* (I, J) needs the new values of tiles (I-1, J) and (I, J-1) and the old   */
+/* ones of (I+1, J) and (I, J+1), so the tiles on one anti-diagonal         */
+/* I + J = d can be updated at the same time                                */
+/* ************************************************************************ */
+static double calculateWavefront(struct calculation_arguments const* arguments, double* Matrix)
+{
+    double maxResiduum = 0;
+
+    int lines = arguments->lines;
+    int columns = arguments->columns;
+    int tiles_i = (lines - 2 + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_j = (columns - 2 + TILE_SIZE - 1) / TILE_SIZE;
+
+#pragma omp parallel reduction(max : maxResiduum)
+    {
+        /* over all anti-diagonals of tiles; omp for ends with a barrier */
+        for (int d = 0; d < tiles_i + tiles_j - 1; d++) {
+            int first = (d < tiles_j) ? 0 : d - tiles_j + 1;
+            int last = (d < tiles_i) ? d : tiles_i - 1;
+
+#pragma omp for schedule(dynamic)
+            for (int I = first; I <= last; I++) {
+                int J = d - I;
+                int i0 = 1 + I * TILE_SIZE;
+                int j0 = 1 + J * TILE_SIZE;
+                int i1 = (i0 + TILE_SIZE < lines - 1) ? i0 + TILE_SIZE : lines - 1;
+                int j1 = (j0 + TILE_SIZE < columns - 1) ? j0 + TILE_SIZE : columns - 1;
+
+                maxResiduum = calculateBlock(arguments, Matrix, Matrix, i0, i1, j0, j1, maxResiduum);
+            }
+        }
+    }
+
+    return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void calculate(
+    struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+    int i; /* local variable for loops   */
+    int m1, m2; /* used as indices for old and new matrices       */
+    double maxResiduum; /* maximum residuum of current iteration          */
+
+    /* Jacobi with PARTDIFF_OVERLAP: the ghost frame of each matrix         */
+    int overlap = (options->method == METH_JACOBI && options->overlap);
+    MPI_Request halo[2][8];
+
+    if (overlap) {
+        for (i = 0; i < 2; i++) {
+            initGhosts(arguments, arguments->Matrix[i].data, halo[i]);
+        }
+    }
+
+    /* Gauss-Seidel: the pipeline of outstanding sends                     */
+    MPI_Request sends[4] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL, MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+
+    /* TERM_PREC: the maximum of iteration t is reduced without blocking   */
+    /* and only awaited after iteration t + lag; waiting at once would      */
+    /* drain the Gauss-Seidel pipeline. The last lag iterations run after   */
+    /* the precision was reached, which only makes the result more precise */
+    int lag = (options->method == METH_GAUSS_SEIDEL) ? arguments->dims[0] + arguments->dims[1] - 2 : 0;
+    double* residua = allocateMemory((lag + 1) * sizeof(double));
+    MPI_Request* checks = allocateMemory((lag + 1) * sizeof(MPI_Request));
+
+    for (i = 0; i <= lag; i++) {
+        checks[i] = MPI_REQUEST_NULL;
+    }
+
+    /* initialize m1 and m2 depending on algorithm */
+    if (options->method == METH_GAUSS_SEIDEL) {
+        m1 = 0;
+        m2 = 0;
+    } else {
+        m1 = 0;
+        m2 = 1;
+    }
+
+    while (options->term_iteration > 0) {
+        double* Matrix_Out = arguments->Matrix[m1].data;
+        double* Matrix_In = arguments->Matrix[m2].data;
+
+        if (overlap) {
+            maxResiduum = calculateOverlapped(arguments, Matrix_Out, Matrix_In, halo[m2]);
+        } else if (options->method == METH_JACOBI) {
+            exchangeGhosts(arguments, Matrix_In);
+            maxResiduum = calculateRows(arguments, Matrix_Out, Matrix_In);
+        } else {
+            receiveGhosts(arguments, Matrix_In, results->stat_iteration == 0, sends);
+            maxResiduum = calculateWavefront(arguments, Matrix_In);
+        }
+
+        results->stat_iteration++;
+
+        /* exchange m1 and m2 */
+        i = m1;
+        m1 = m2;
+        m2 = i;
+
+        /* check for stopping calculation, depending on termination method; */
+        /* all processes continue or stop with the same maxima              */
+        if (options->termination == TERM_PREC) {
+            int t = results->stat_iteration;
+
+            residua[t % (lag + 1)] = maxResiduum;
+            MPI_Iallreduce(MPI_IN_PLACE, &residua[t % (lag + 1)], 1, MPI_DOUBLE, MPI_MAX, arguments->comm,
+                &checks[t % (lag + 1)]);
+
+            if (t > lag) {
+                MPI_Wait(&checks[(t - lag) % (lag + 1)], MPI_STATUS_IGNORE);
+
+                if (residua[(t - lag) % (lag + 1)] < options->term_precision) {
+                    options->term_iteration = 0;
+                }
+            }
+        } else if (options->termination == TERM_ITER) {
+            options->term_iteration--;
+        }
+
+        if (options->method == METH_GAUSS_SEIDEL) {
+            sendBorders(arguments, Matrix_In, options->term_iteration == 0, sends);
+        }
+    }
+
+    MPI_Waitall(lag + 1, checks, MPI_STATUSES_IGNORE);
+    MPI_Waitall(4, sends, MPI_STATUSES_IGNORE);
+
+    /* the residuum of the last iteration is only needed once */
+    MPI_Allreduce(MPI_IN_PLACE, &maxResiduum, 1, MPI_DOUBLE, MPI_MAX, arguments->comm);
+    results->stat_precision = maxResiduum;
+
+    free(residua);
+    free(checks);
+
+    if (overlap) {
+        for (i = 0; i < 2; i++) {
+            for (int r = 0; r < 8; r++) {
+                MPI_Request_free(&halo[i][r]);
+            }
+        }
+    }
+
+    results->m = m2;
+}
+
+/* ************************************************************************ */
+/*  displayStatistics: displays some statistics about the calculation       */
+/* ************************************************************************ */
+static void displayStatistics(
+    struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+    (void)arguments;
+
+    double time = (comp_time.tv_sec - start_time.tv_sec) + (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
+    printf("Berechnungszeit:    %f s \n", time);
+
+    printf("Berechnungsmethode: ");
+
+    if (options->method == METH_GAUSS_SEIDEL) {
+        printf("Gauss-Seidel");
+    } else if (options->method == METH_JACOBI) {
+        printf("Jacobi");
+    }
+
+    printf("\n");
+    printf("Interlines:         %d\n", options->interlines);
+    printf("Stoerfunktion:      ");
+
+    if (options->inf_func == FUNC_F0) {
+        printf("f(x,y)=0");
+    } else if (options->inf_func == FUNC_FPISIN) {
+        printf("f(x,y)=2pi^2*sin(pi*x)sin(pi*y)");
+    }
+
+    printf("\n");
+    printf("Terminierung:       ");
+
+    if (options->termination == TERM_PREC) {
+        printf("Hinreichende Genaugkeit");
+    } else if (options->termination == TERM_ITER) {
+        printf("Anzahl der Iterationen");
+    }
+
+    printf("\n");
+    printf("Anzahl Iterationen: %d\n", results->stat_iteration);
+    printf("Norm des Fehlers:   %.11e\n", results->stat_precision);
+}
+
+/* ************************************************************************ */
+/*  displayMatrix: prints the same nine rows and columns as DisplayMatrix   */
+/*  The process holding an element sends it to process 0                    */
+/* ************************************************************************ */
+static void displayMatrix(
+    struct calculation_arguments* arguments, struct calculation_results* results, struct options* options)
+{
+    int x, y;
+    double value;
+
+    int N = arguments->N;
+    int interlines = options->interlines;
+    double const* data = arguments->Matrix[results->m].data;
+    int stride = arguments->Matrix[results->m].stride;
+
+    if (arguments->rank == 0) {
+        printf("Matrix:\n");
+    }
+
+    for (y = 0; y < 9; y++) {
+        int i = y * (interlines + 1);
+
+        for (x = 0; x < 9; x++) {
+            int j = x * (interlines + 1);
+            int coords[2] = { owner(N - 1, arguments->dims[0], i), owner(N - 1, arguments->dims[1], j) };
+            int rank;
+
+            MPI_Cart_rank(arguments->comm, coords, &rank);
+
+            if (arguments->rank == rank) {
+                int k = i - arguments->from[0] + 1;
+                int l = j - arguments->from[1] + 1;
+
+                value = data[(size_t)k * stride + l];
+
+                if (rank != 0) {
+                    MPI_Send(&value, 1, MPI_DOUBLE, 0, y * 9 + x, arguments->comm);
+                }
+            }
+
+            if (arguments->rank == 0) {
+                if (rank != 0) {
+                    MPI_Recv(&value, 1, MPI_DOUBLE, rank, y * 9 + x, arguments->comm, MPI_STATUS_IGNORE);
+                }
+
+                printf("%11.8f", value);
+            }
+        }
+
+        if (arguments->rank == 0) {
+            printf("\n");
+        }
+    }
+
+    fflush(stdout);
+}
+
+/* ************************************************************************ */
+/*  main                                                                    */
+/* ************************************************************************ */
+int main(int argc, char** argv)
+{
+    struct options options;
+    struct calculation_arguments arguments;
+    struct calculation_results results;
+    int world_rank, world_size;
+    int periods[2] = { 0, 0 };
+    int provided;
+    int status = PARAMS_OK;
+    MPI_Comm active;
+
+    /* only the master thread of each process calls MPI */
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+
+    if (provided < MPI_THREAD_FUNNELED) {
+        if (world_rank == 0) {
+            printf("MPI unterstuetzt keine Threads (MPI_THREAD_FUNNELED).\n");
+        }
+
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    /* get parameters; only process 0 reads and prints them */
+    if (world_rank == 0) {
+        status = AskParams(&options, argc, argv);
+    }
+
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&options, sizeof(options), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    /* every process checks the options it works with; all of them see the  */
+    /* same values, so they all stop together                                */
+    if (status == PARAMS_OK && !CheckParams(&options)) {
+        if (world_rank == 0) {
+            printf("Ungueltige Parameter, siehe: %s help\n", argv[0]);
+        }
+
+        status = PARAMS_INVALID;
+    }
+
+    if (status != PARAMS_OK) {
+        MPI_Finalize();
+        return (status == PARAMS_INVALID) ? 1 : 0;
+    }
+
+    if (options.number > 0) {
+        omp_set_num_threads(options.number);
+    }
+
+    /* a grid as square as possible; every process needs at least one row   */
+    /* and one column, the remaining processes stay idle                     */
+    arguments.dims[0] = 0;
+    arguments.dims[1] = 0;
+    MPI_Dims_create(world_size, 2, arguments.dims);
+
+    for (int d = 0; d < 2; d++) {
+        if (arguments.dims[d] > options.interlines * 8 + 9 - 2) {
+            arguments.dims[d] = options.interlines * 8 + 9 - 2;
+        }
+    }
+
+    MPI_Comm_split(MPI_COMM_WORLD, (world_rank < arguments.dims[0] * arguments.dims[1]) ? 0 : MPI_UNDEFINED,
+        world_rank, &active);
+
+    if (active == MPI_COMM_NULL) {
+        MPI_Finalize();
+        return 0;
+    }
+
+    /* the ranks may be reordered to fit the network */
+    MPI_Cart_create(active, 2, arguments.dims, periods, 1, &arguments.comm);
+    MPI_Comm_free(&active);
+
+    MPI_Comm_rank(arguments.comm, &arguments.rank);
+    MPI_Comm_size(arguments.comm, &arguments.size);
+
+    initVariables(&arguments, &results, &options);
+
+    /*  get and initialize variables and matrices */
+    allocateMatrices(&arguments, &options);
+    initMatrices(&arguments, &options);
+    initSourceTerm(&arguments, &options);
+
+    /*  start timer         */
+    MPI_Barrier(arguments.comm);
+    gettimeofday(&start_time, NULL);
+    /*  solve the equation  */
+    calculate(&arguments, &results, &options);
+    /*  stop timer          */
+    MPI_Barrier(arguments.comm);
+    gettimeofday(&comp_time, NULL);
+
+    /*  display some  statistics */
+    if (arguments.rank == 0) {
+        displayStatistics(&arguments, &results, &options);
+    }
+
+    displayMatrix(&arguments, &results, &options);
+
+    /*  free memory     */
+    freeMatrices(&arguments);
+
+    MPI_Comm_free(&arguments.comm);
+    MPI_Finalize();
+
+    return 0;
+}
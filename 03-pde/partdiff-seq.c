@@ -17,19 +17,33 @@
 /* ************************************************************************ */
 /* Include standard header file.                                            */
 /* ************************************************************************ */
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, madvise() */
+
 #include "partdiff-seq.h"
 #include <malloc.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 
+/* ************************************************************************ */
+/* A matrix is stored row by row in one flat block of memory; rows are      */
+/* padded to an odd number of cache lines against cache-set aliasing        */
+/* ************************************************************************ */
+struct grid {
+    double* data; /* element (i, j) is data[i * stride + j]          */
+    int stride; /* distance between two rows in doubles            */
+};
+
 struct calculation_arguments {
     int N; /* number of spaces between lines (lines=N+1)     */
     int num_matrices; /* number of matrices                             */
-    double*** Matrix; /* index matrix used for addressing M             */
-    double* M; /* two matrices with real values                  */
+    struct grid* Matrix; /* the matrices, pointing into M                  */
+    double* M; /* memory of all matrices                         */
+    size_t M_size; /* bytes mapped for M                             */
     double h; /* length of a space between two lines            */
+    double* sin_pih; /* sin(pi*h*k) per line (FUNC_FPISIN)             */
 };
 
 struct calculation_results {
@@ -55,6 +69,7 @@ static void initVariables(
     arguments->N = options->interlines * 8 + 9 - 1;
     arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
     arguments->h = (float)(((float)(1)) / (arguments->N));
+    arguments->sin_pih = NULL;
 
     results->m = 0;
     results->stat_iteration = 0;
@@ -66,14 +81,9 @@ static void initVariables(
 /* ************************************************************************ */
 static void freeMatrices(struct calculation_arguments* arguments)
 {
-    int i;
-
-    for (i = 0; i < arguments->num_matrices; i++) {
-        free(arguments->Matrix[i]);
-    }
-
     free(arguments->Matrix);
-    free(arguments->M);
+    munmap(arguments->M, arguments->M_size);
+    free(arguments->sin_pih);
 }
 
 /* ************************************************************************ */
@@ -93,24 +103,70 @@ static void* allocateMemory(size_t size)
     return p;
 }
 
+/* ************************************************************************ */
+/* allocateGrid ()                                                          */
+/* maps page-aligned memory for matrices, backed by huge pages if wanted;   */
+/* *size is rounded up to the size actually mapped                          */
+/* ************************************************************************ */
+static void* allocateGrid(size_t* size, int huge_pages)
+{
+    void* p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (huge_pages == HUGE_PAGES_EXPLICIT) {
+        size_t rounded = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+        if (p != MAP_FAILED) {
+            *size = rounded;
+            return p;
+        }
+    }
+#endif
+
+    p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED) {
+        printf("\n\nSpeicherprobleme!\n");
+        /* exit program */
+        exit(1);
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (huge_pages != HUGE_PAGES_OFF) {
+        /* only a hint, the matrices work without transparent huge pages */
+        (void)madvise(p, *size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
-static void allocateMatrices(struct calculation_arguments* arguments)
+static void allocateMatrices(struct calculation_arguments* arguments, struct options* options)
 {
-    int i, j;
+    int i;
 
     int N = arguments->N;
+    int per_line = CACHE_LINE / sizeof(double);
 
-    arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) * sizeof(double));
-    arguments->Matrix = allocateMemory(arguments->num_matrices * sizeof(double**));
+    /* round the rows up to an odd number of cache lines */
+    int cache_lines = (N + 1 + per_line - 1) / per_line;
+    int stride = ((cache_lines % 2 == 0) ? cache_lines + 1 : cache_lines) * per_line;
 
-    for (i = 0; i <= arguments->num_matrices; i++) {
-        arguments->Matrix[i] = allocateMemory((N + 1) * sizeof(double*));
+    /* one extra cache line keeps row i of two matrices in different sets */
+    size_t pitch = (size_t)(N + 1) * stride + per_line;
 
-        for (j = 0; j <= N; j++) {
-            arguments->Matrix[i][j] = (double*)(arguments->M + (i * (N + 1) * (N + 1)) + (j * (N + 1)));
-        }
+    arguments->M_size = arguments->num_matrices * pitch * sizeof(double);
+    arguments->M = allocateGrid(&arguments->M_size, options->huge_pages);
+    arguments->Matrix = allocateMemory(arguments->num_matrices * sizeof(struct grid));
+
+    for (i = 0; i < arguments->num_matrices; i++) {
+        arguments->Matrix[i].data = arguments->M + i * pitch;
+        arguments->Matrix[i].stride = stride;
     }
 }
 
@@ -123,13 +179,13 @@ static void initMatrices(struct calculation_arguments* arguments, struct options
 
     int N = arguments->N;
     double h = arguments->h;
-    double*** Matrix = arguments->Matrix;
+    struct grid* Matrix = arguments->Matrix;
 
     /* initialize matrix/matrices with zeros */
     for (g = 0; g < arguments->num_matrices; g++) {
         for (i = 0; i <= N; i++) {
             for (j = 0; j <= N; j++) {
-                Matrix[g][i][j] = 0;
+                Matrix[g].data[i * Matrix[g].stride + j] = 0;
             }
         }
     }
@@ -138,31 +194,49 @@ static void initMatrices(struct calculation_arguments* arguments, struct options
     if (options->inf_func == FUNC_F0) {
         for (i = 0; i < N; i++) {
             for (j = 0; j < arguments->num_matrices; j++) {
-                Matrix[j][i][0] = 3 + (1 - (h * i)); // Linke Kante
-                Matrix[j][N][i] = 3 - (h * i); // Untere Kante
-                Matrix[j][N - i][N] = 2 + h * i; // Rechte Kante
-                Matrix[j][0][N - i] = 3 + h * i; // Obere Kante
+                double* data = Matrix[j].data;
+                int stride = Matrix[j].stride;
+
+                data[i * stride] = 3 + (1 - (h * i)); // Linke Kante
+                data[N * stride + i] = 3 - (h * i); // Untere Kante
+                data[(N - i) * stride + N] = 2 + h * i; // Rechte Kante
+                data[N - i] = 3 + h * i; // Obere Kante
             }
         }
     }
 }
 
+/* ************************************************************************ */
+/* initSourceTerm: tabulates the inference function                         */
+/* f(x,y) = 2pi^2*sin(pi*x)sin(pi*y) is separable; sin(pi*h*k) is computed  */
+/* once per line instead of twice per element and iteration                 */
+/* ************************************************************************ */
+static void initSourceTerm(struct calculation_arguments* arguments, struct options* options)
+{
+    int k;
+
+    if (options->inf_func != FUNC_FPISIN) {
+        return;
+    }
+
+    arguments->sin_pih = allocateMemory((arguments->N + 1) * sizeof(double));
+
+    for (k = 0; k <= arguments->N; k++) {
+        arguments->sin_pih[k] = sin((double)(k)*PI * arguments->h);
+    }
+}
+
 /* ************************************************************************ */
 /* getResiduum: calculates residuum                                         */
-/* Input: x,y - actual column and row                                       */
+/* Input: x,y - actual row and column                                       */
+/*        sin_pih - table of initSourceTerm, NULL for FUNC_F0               */
 /* ************************************************************************ */
-double getResiduum(struct calculation_arguments* arguments, struct options* options, int x, int y, double star)
+static inline double getResiduum(double h, double const* sin_pih, int x, int y, double star)
 {
-    double* result = malloc(sizeof(double));
-    if (options->inf_func == FUNC_F0) {
-        *result = ((-star) / 4.0);
-        return *result;
+    if (sin_pih == NULL) {
+        return ((-star) / 4.0);
     } else {
-        *result = ((TWO_PI_SQUARE * sin((double)(y)*PI * arguments->h) * sin((double)(x)*PI * arguments->h)
-                           * arguments->h * arguments->h
-                       - star)
-            / 4.0);
-        return *result;
+        return ((TWO_PI_SQUARE * sin_pih[y] * sin_pih[x] * h * h - star) / 4.0);
     }
 }
 
@@ -177,9 +251,12 @@ static void calculate(
     double star; /* four times center value minus 4 neigh.b values */
     double korrektur;
     double residuum; /* residuum of current iteration                  */
+    double maxResiduum; /* maximum residuum of current iteration          */
 
     int N = arguments->N;
-    double*** Matrix = arguments->Matrix;
+    int stride = arguments->Matrix[0].stride;
+    double h = arguments->h;
+    double const* sin_pih = arguments->sin_pih;
 
     /* initialize m1 and m2 depending on algorithm */
     if (options->method == METH_GAUSS_SEIDEL) {
@@ -191,27 +268,35 @@ static void calculate(
     }
 
     while (options->term_iteration > 0) {
+        double* Matrix_Out = arguments->Matrix[m1].data;
+        double* Matrix_In = arguments->Matrix[m2].data;
+
+        maxResiduum = 0;
+
+        /* over all rows; row by row as the matrices are stored. Element    */
+        /* (i, j) sees the same new and old neighbours as in column order,  */
+        /* so Gauss-Seidel computes exactly the same values                 */
+        for (i = 1; i < N; i++) {
+            double const* above = Matrix_In + (i - 1) * stride;
+            double const* row = Matrix_In + i * stride;
+            double const* below = Matrix_In + (i + 1) * stride;
+            double* out = Matrix_Out + i * stride;
 
-        /* over all rows */
-        for (j = 1; j < N; j++) {
             /* over all columns */
-            for (i = 1; i < N; i++) {
-                if (i == 1 && j == 1) {
-                    results->stat_precision = 0;
-                }
-                star = -Matrix[m2][i - 1][j] - Matrix[m2][i][j - 1] - Matrix[m2][i][j + 1] - Matrix[m2][i + 1][j]
-                    + 4.0 * Matrix[m2][i][j];
-
-                residuum = getResiduum(arguments, options, i, j, star);
+            for (j = 1; j < N; j++) {
+                star = -above[j] - row[j - 1] - row[j + 1] - below[j] + 4.0 * row[j];
+
+                residuum = getResiduum(h, sin_pih, i, j, star);
                 korrektur = residuum;
                 residuum = (residuum < 0) ? -residuum : residuum;
-                results->stat_precision = (residuum < results->stat_precision) ? results->stat_precision : residuum;
+                maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
 
-                Matrix[m1][i][j] = Matrix[m2][i][j] + korrektur;
+                out[j] = row[j] + korrektur;
             }
         }
 
         results->stat_iteration++;
+        results->stat_precision = maxResiduum;
 
         /* exchange m1 and m2 */
         i = m1;
@@ -284,13 +369,19 @@ int main(int argc, char** argv)
     struct calculation_results results;
 
     /* get parameters */
-    AskParams(&options, argc, argv);
+    switch (AskParams(&options, argc, argv)) {
+    case PARAMS_USAGE:
+        return 0;
+    case PARAMS_INVALID:
+        return 1;
+    }
 
     initVariables(&arguments, &results, &options);
 
     /*  get and initialize variables and matrices */
-    allocateMatrices(&arguments);
+    allocateMatrices(&arguments, &options);
     initMatrices(&arguments, &options);
+    initSourceTerm(&arguments, &options);
 
     /*  start timer         */
     gettimeofday(&start_time, NULL);
@@ -301,7 +392,7 @@ int main(int argc, char** argv)
 
     /*  display some  statistics */
     displayStatistics(&arguments, &results, &options);
-    DisplayMatrix("Matrix:", arguments.Matrix[results.m][0], options.interlines);
+    DisplayMatrix("Matrix:", arguments.Matrix[results.m].data, options.interlines, arguments.Matrix[results.m].stride);
 
     /*  free memory     */
     freeMatrices(&arguments);
@@ -28,12 +28,22 @@
 #endif
 #define TWO_PI_SQUARE (2 * PI * PI)
 #define MAX_ITERATION 200000
+/* largest value for which N * stride, the offset of the last row, fits in int */
+#define MAX_INTERLINES 5000
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI 2
 #define FUNC_F0 1
 #define FUNC_FPISIN 2
 #define TERM_PREC 1
 #define TERM_ITER 2
+#define CACHE_LINE 64
+#define HUGE_PAGES_OFF 0
+#define HUGE_PAGES_TRANSPARENT 1
+#define HUGE_PAGES_EXPLICIT 2
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define PARAMS_OK 0
+#define PARAMS_USAGE 1
+#define PARAMS_INVALID 2
 
 struct options {
     int number; /* Number of threads                              */
@@ -43,6 +53,8 @@ struct options {
     int termination; /* termination condition                          */
     int term_iteration; /* terminate if iteration number reached          */
     double term_precision; /* terminate if precision reached                 */
+    int huge_pages; /* huge pages for matrices (PARTDIFF_HUGEPAGES)   */
+    int overlap; /* partdiff-par: hide the halo exchange          */
 };
 
 /* *************************** */
@@ -52,6 +64,7 @@ struct options {
 /* - askparams.c               */
 /* - displaymatrix.c           */
 /* *************************** */
-void AskParams(struct options*, int, char**);
+int AskParams(struct options*, int, char**);
+int CheckParams(struct options const*);
 
-void DisplayMatrix(char*, double*, int);
+void DisplayMatrix(char*, double*, int, int);
@@ -40,8 +40,13 @@
 /****************************************************************************/
 /** int *method;                                                           **/
 /**         Bezeichnet das bei der L"osung der Poissongleichung zu         **/
-/**         verwendende Verfahren (Gauß-Seidel oder Jacobi).               **/
-/** Werte:  METH_GAUSS_SEIDEL  oder METH_JACOBI (definierte Konstanten)    **/
+/**         verwendende Verfahren (Gauß-Seidel, Jacobi, Gauß-Seidel        **/
+/**         in Rot-Schwarz-Reihenfolge, SOR in beiden Reihenfolgen,        **/
+/**         Mehrgitter, CG oder Tschebyscheff-beschleunigtes Jacobi).      **/
+/** Werte:  METH_GAUSS_SEIDEL, METH_JACOBI, METH_RED_BLACK, METH_SOR,      **/
+/**         METH_SOR_RED_BLACK, METH_MULTIGRID, METH_CG oder               **/
+/**         METH_CHEBYSHEV                                                 **/
+/**         (definierte Konstanten)                                        **/
 /****************************************************************************/
 /** int *interlines:                                                       **/
 /**         Gibt die Zwischenzeilen zwischen den auszugebenden             **/
@@ -86,9 +91,19 @@ static void usage(char *name) {
   printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
   printf("\n");
   printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-  printf("  - method:    calculation method (1 .. 2)\n");
+  printf("  - method:    calculation method (1 .. 8)\n");
   printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
   printf("                 %1d: Jacobi\n", METH_JACOBI);
+  printf("                 %1d: Gauß-Seidel (red-black)\n", METH_RED_BLACK);
+  printf("                 %1d: SOR\n", METH_SOR);
+  printf("                 %1d: SOR (red-black)\n", METH_SOR_RED_BLACK);
+  printf("                 %1d: multigrid; fastest for interlines + 1 a\n",
+         METH_MULTIGRID);
+  printf("                    power of two, other sizes interpolate between\n");
+  printf("                    levels and converge a little slower\n");
+  printf("                 %1d: conjugate gradient\n", METH_CG);
+  printf("                 %1d: Jacobi (Chebyshev-accelerated)\n",
+         METH_CHEBYSHEV);
   printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
   printf("                 matrixsize = (interlines * 8) + 9\n");
   printf("  - func:      interference function (1 .. 2)\n");
@@ -103,6 +118,62 @@ static void usage(char *name) {
   printf("                 precision:  1e-4 .. 1e-20\n");
   printf("                 iterations:    1 .. %d\n", MAX_ITERATION);
   printf("\n");
+  printf("Environment:\n");
+  printf("  - OMP_SCHEDULE: schedule of the parallel loops, e.g. \"dynamic,4\"\n");
+  printf("                 (default: static)\n");
+  printf("  - PARTDIFF_TILE: edge length of the tiles of the parallel\n");
+  printf("                 Gauß-Seidel wavefront and rows per tile of the\n");
+  printf("                 time-blocked Jacobi method (1 .. %d,\n",
+         MAX_TILE_SIZE);
+  printf("                 default: %d)\n", DEFAULT_TILE_SIZE);
+  printf("  - PARTDIFF_TIME_DEPTH: Jacobi iterations per tile with number of\n");
+  printf("                 iterations as termination (1 .. %d, default: 1)\n",
+         MAX_TIME_DEPTH);
+  printf("  - PARTDIFF_HUGEPAGES: huge pages for the matrices\n");
+  printf("                 %1d: off\n", HUGE_PAGES_OFF);
+  printf("                 %1d: transparent huge pages (default)\n",
+         HUGE_PAGES_TRANSPARENT);
+  printf("                 %1d: reserved huge pages (MAP_HUGETLB)\n",
+         HUGE_PAGES_EXPLICIT);
+  printf("  - PARTDIFF_OMEGA: relaxation factor of SOR (0 .. 2, default:\n");
+  printf("                 2 / (1 + sin(pi * h)), optimal for f(x,y) = 0)\n");
+  printf("  - PARTDIFF_CYCLE: multigrid cycle\n");
+  printf("                 %1d: V-cycle (default)\n", MG_CYCLE_V);
+  printf("                 %1d: F-cycle\n", MG_CYCLE_F);
+  printf("  - PARTDIFF_PRECOND: preconditioner of the conjugate gradient method\n");
+  printf("                 %1d: none\n", PRECOND_NONE);
+  printf("                 %1d: Jacobi; the diagonal is 4 everywhere, so the\n",
+         PRECOND_JACOBI);
+  printf("                    iterates are the same as without one\n");
+  printf("                 %1d: symmetric Gauß-Seidel (red-black, default)\n",
+         PRECOND_SGS);
+  printf("  - PARTDIFF_PRECISION: arithmetic of the Jacobi sweeps\n");
+  printf("                 %1d: double (default)\n", PRECISION_DOUBLE);
+  printf("                 %1d: float, corrected in double every %d sweeps\n",
+         PRECISION_MIXED, MIXED_SWEEPS);
+  printf("  - PARTDIFF_CHECK_INTERVAL: with termination %d, compute the\n",
+         TERM_PREC);
+  printf("                 residuum only every n-th iteration (default 1)\n");
+  printf("  - PARTDIFF_CHECK_ASYNC: %d: residuum computed by the solver "
+         "(default)\n",
+         CHECK_SYNC);
+  printf("                 %1d: residuum of a copy computed by a helper\n",
+         CHECK_ASYNC);
+  printf("                    thread while Jacobi goes on; only for method\n");
+  printf("                    %d with termination %d, and not together with\n",
+         METH_JACOBI, TERM_PREC);
+  printf("                    PARTDIFF_PRECISION=%d, PARTDIFF_INPLACE or\n",
+         PRECISION_MIXED);
+  printf("                    PARTDIFF_SYMMETRY\n");
+  printf("  - PARTDIFF_INPLACE: 1: Jacobi on one matrix with line buffers,\n");
+  printf("                    half the memory (default 0)\n");
+  printf("  - PARTDIFF_SYMMETRY: 1: Jacobi and red-black solve only the part\n");
+  printf("                    of the matrix not repeated by symmetry\n");
+  printf("                    (default 0)\n");
+  printf("  - PARTDIFF_ASYNC: 1: Gauß-Seidel and SOR without barriers, every\n");
+  printf("                    thread sweeps its rows with the values of its\n");
+  printf("                    neighbours as they are (default 0)\n");
+  printf("\n");
   printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
@@ -112,7 +183,10 @@ static int check_number(struct options *options) {
 
 static int check_method(struct options *options) {
   return (options->method == METH_GAUSS_SEIDEL ||
-          options->method == METH_JACOBI);
+          options->method == METH_JACOBI || options->method == METH_RED_BLACK ||
+          options->method == METH_SOR || options->method == METH_SOR_RED_BLACK ||
+          options->method == METH_MULTIGRID || options->method == METH_CG ||
+          options->method == METH_CHEBYSHEV);
 }
 
 static int check_interlines(struct options *options) {
@@ -137,6 +211,211 @@ static int check_term_iteration(struct options *options) {
           options->term_iteration <= MAX_ITERATION);
 }
 
+static int check_tile_size(struct options *options) {
+  return (options->tile_size >= 1 && options->tile_size <= MAX_TILE_SIZE);
+}
+
+static int check_time_depth(struct options *options) {
+  return (options->time_depth >= 1 && options->time_depth <= MAX_TIME_DEPTH);
+}
+
+static int check_huge_pages(struct options *options) {
+  return (options->huge_pages == HUGE_PAGES_OFF ||
+          options->huge_pages == HUGE_PAGES_TRANSPARENT ||
+          options->huge_pages == HUGE_PAGES_EXPLICIT);
+}
+
+static int check_omega(struct options *options) {
+  return (options->omega > 0 && options->omega < 2);
+}
+
+static int check_cycle(struct options *options) {
+  return (options->cycle == MG_CYCLE_V || options->cycle == MG_CYCLE_F);
+}
+
+static int check_precision(struct options *options) {
+  return (options->precision == PRECISION_DOUBLE ||
+          options->precision == PRECISION_MIXED);
+}
+
+static int check_check_interval(struct options *options) {
+  return (options->check_interval >= 1);
+}
+
+static int check_check_async(struct options *options) {
+  return (options->check_async == CHECK_SYNC ||
+          options->check_async == CHECK_ASYNC);
+}
+
+/* the helper thread only exists in the plain Jacobi solver */
+static int check_check_async_mode(struct options *options) {
+  return (options->check_async == CHECK_SYNC ||
+          (options->method == METH_JACOBI &&
+           options->termination == TERM_PREC &&
+           options->precision == PRECISION_DOUBLE && !options->inplace &&
+           !options->symmetry));
+}
+
+static int check_inplace(struct options *options) {
+  return (options->inplace == 0 || options->inplace == 1);
+}
+
+static int check_symmetry(struct options *options) {
+  return (options->symmetry == 0 || options->symmetry == 1);
+}
+
+static int check_async(struct options *options) {
+  return (options->async == 0 || options->async == 1);
+}
+
+static int check_precond(struct options *options) {
+  return (options->precond == PRECOND_NONE ||
+          options->precond == PRECOND_JACOBI ||
+          options->precond == PRECOND_SGS);
+}
+
+/* reads the tuning parameters that are not part of the command line */
+static void askEnvironment(struct options *options, char *name) {
+  char const *env;
+  int ret;
+
+  options->tile_size = DEFAULT_TILE_SIZE;
+  options->time_depth = 1;
+  options->huge_pages = HUGE_PAGES_TRANSPARENT;
+
+  if ((env = getenv("PARTDIFF_TILE")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->tile_size));
+
+    if (ret != 1 || !check_tile_size(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  if ((env = getenv("PARTDIFF_TIME_DEPTH")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->time_depth));
+
+    if (ret != 1 || !check_time_depth(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  if ((env = getenv("PARTDIFF_HUGEPAGES")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->huge_pages));
+
+    if (ret != 1 || !check_huge_pages(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  /* optimal for the model problem: omega = 2 / (1 + sin(pi * h)) */
+  options->omega = 2.0 / (1.0 + sin(PI / (options->interlines * 8 + 8)));
+
+  if ((env = getenv("PARTDIFF_OMEGA")) != NULL) {
+    ret = sscanf(env, "%lf", &(options->omega));
+
+    if (ret != 1 || !check_omega(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->cycle = MG_CYCLE_V;
+
+  if ((env = getenv("PARTDIFF_CYCLE")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->cycle));
+
+    if (ret != 1 || !check_cycle(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->precond = PRECOND_SGS;
+
+  if ((env = getenv("PARTDIFF_PRECOND")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->precond));
+
+    if (ret != 1 || !check_precond(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->precision = PRECISION_DOUBLE;
+
+  if ((env = getenv("PARTDIFF_PRECISION")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->precision));
+
+    if (ret != 1 || !check_precision(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->check_interval = 1;
+
+  if ((env = getenv("PARTDIFF_CHECK_INTERVAL")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->check_interval));
+
+    if (ret != 1 || !check_check_interval(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->check_async = CHECK_SYNC;
+
+  if ((env = getenv("PARTDIFF_CHECK_ASYNC")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->check_async));
+
+    if (ret != 1 || !check_check_async(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->inplace = 0;
+
+  if ((env = getenv("PARTDIFF_INPLACE")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->inplace));
+
+    if (ret != 1 || !check_inplace(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->symmetry = 0;
+
+  if ((env = getenv("PARTDIFF_SYMMETRY")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->symmetry));
+
+    if (ret != 1 || !check_symmetry(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->async = 0;
+
+  if ((env = getenv("PARTDIFF_ASYNC")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->async));
+
+    if (ret != 1 || !check_async(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  if (!check_check_async_mode(options)) {
+    usage(name);
+    exit(1);
+  }
+}
+
 void askParams(struct options *options, int argc, char **argv) {
   int ret;
 
@@ -168,6 +447,12 @@ void askParams(struct options *options, int argc, char **argv) {
       printf("Select calculation method:\n");
       printf("  %1d: Gauß-Seidel.\n", METH_GAUSS_SEIDEL);
       printf("  %1d: Jacobi.\n", METH_JACOBI);
+      printf("  %1d: Gauß-Seidel (red-black).\n", METH_RED_BLACK);
+      printf("  %1d: SOR.\n", METH_SOR);
+      printf("  %1d: SOR (red-black).\n", METH_SOR_RED_BLACK);
+      printf("  %1d: Multigrid.\n", METH_MULTIGRID);
+      printf("  %1d: Conjugate gradient.\n", METH_CG);
+      printf("  %1d: Jacobi (Chebyshev-accelerated).\n", METH_CHEBYSHEV);
       printf("method> ");
       fflush(stdout);
       ret = scanf("%" SCNu64, &(options->method));
@@ -295,4 +580,6 @@ void askParams(struct options *options, int argc, char **argv) {
       }
     }
   }
+
+  askEnvironment(options, argv[0]);
 }
@@ -8,8 +8,10 @@
 /**                                                                        **/
 /** File:      partdiff.c                                                  **/
 /**                                                                        **/
-/** Purpose:   Partial differential equation solver for Gauß-Seidel and    **/
-/**            Jacobi method.                                              **/
+/** Purpose:   Partial differential equation solver for Gauß-Seidel,       **/
+/**            red-black Gauß-Seidel, SOR, (Chebyshev-accelerated or       **/
+/**            mixed-precision) Jacobi, multigrid and conjugate gradient   **/
+/**            method.                                                     **/
 /**                                                                        **/
 /****************************************************************************/
 /****************************************************************************/
@@ -18,23 +20,63 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, madvise() */
 
 #include <inttypes.h>
 #include <malloc.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "partdiff.h"
 
+/* ************************************************************************ */
+/* A matrix is stored row by row in one flat block of memory. Rows are      */
+/* padded to an odd number of cache lines: every row starts SIMD-aligned    */
+/* and neighbouring rows never map to the same cache sets.                  */
+/* ************************************************************************ */
+struct grid {
+  double *data;    /* element (i, j) is data[i * stride + j]              */
+  uint64_t stride; /* distance between two rows in doubles                */
+};
+
+static inline double *gridRow(struct grid const *grid, uint64_t i) {
+  return grid->data + i * grid->stride;
+}
+
+/* the same layout in float, for the sweeps of the mixed-precision Jacobi */
+struct grid_float {
+  float *data;     /* element (i, j) is data[i * stride + j]              */
+  uint64_t stride; /* distance between two rows in floats                 */
+};
+
+static inline float *gridRowFloat(struct grid_float const *grid, uint64_t i) {
+  return grid->data + i * grid->stride;
+}
+
 struct calculation_arguments {
   uint64_t N;            /* number of spaces between lines (lines=N+1)     */
   uint64_t num_matrices; /* number of matrices                             */
+  uint64_t symmetry;     /* symmetry used to store only a sub-domain       */
+  uint64_t rows;         /* lines stored per matrix                        */
+  uint64_t cols;         /* columns stored per line                        */
   double h;              /* length of a space between two lines            */
-  double ***Matrix;      /* index matrix used for addressing M             */
-  double *M;             /* two matrices with real values                  */
+  struct grid *Matrix;   /* the matrices, pointing into M                  */
+  double *M;             /* memory of all matrices                         */
+  size_t M_size;         /* bytes mapped for M                             */
+  double *fpisin_row;    /* fpisin * sin(pi*h*i) per row (FUNC_FPISIN)     */
+  double *sin_col;       /* sin(pi*h*j) per column (FUNC_FPISIN)           */
 };
 
 struct calculation_results {
@@ -44,202 +86,2558 @@ struct calculation_results {
 };
 
 /* ************************************************************************ */
-/* Global variables                                                         */
+/* Global variables                                                         */
+/* ************************************************************************ */
+
+/* time measurement variables */
+struct timeval start_time; /* time when program started                      */
+struct timeval comp_time;  /* time when calculation completed                */
+
+/* ************************************************************************ */
+/* detectSymmetry: symmetry of the problem that calculateSymmetric() can    */
+/* use                                                                      */
+/*                                                                          */
+/* N is always even. FUNC_FPISIN is symmetric about both mid-lines and both */
+/* diagonals, the borders of FUNC_F0 are symmetric about both diagonals.    */
+/* Jacobi and red-black keep these symmetries in every iteration, since     */
+/* the colors of the red-black order are mirrored onto themselves.          */
+/* ************************************************************************ */
+static uint64_t detectSymmetry(struct options const *options) {
+  if (!options->symmetry) {
+    return SYMMETRY_NONE;
+  }
+
+  if (options->method != METH_JACOBI && options->method != METH_RED_BLACK &&
+      options->method != METH_SOR_RED_BLACK) {
+    return SYMMETRY_NONE;
+  }
+
+  return (options->inf_func == FUNC_FPISIN) ? SYMMETRY_FULL
+                                            : SYMMETRY_DIAGONALS;
+}
+
+/* ************************************************************************ */
+/* initVariables: Initializes some global variables                         */
+/* ************************************************************************ */
+static void initVariables(struct calculation_arguments *arguments,
+                          struct calculation_results *results,
+                          struct options const *options) {
+  arguments->N = (options->interlines * 8) + 9 - 1;
+  arguments->symmetry = detectSymmetry(options);
+
+  /* the upper half, and of that the left half for the full symmetry */
+  if (arguments->symmetry == SYMMETRY_NONE) {
+    arguments->rows = arguments->N + 1;
+  } else {
+    arguments->rows = arguments->N / 2 + 2;
+  }
+
+  if (arguments->symmetry == SYMMETRY_FULL) {
+    arguments->cols = arguments->N / 2 + 2;
+  } else {
+    arguments->cols = arguments->N + 1;
+  }
+
+  if (arguments->symmetry != SYMMETRY_NONE) {
+    arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
+  } else if (options->method == METH_CG) {
+    /* u, r, p and z for symmetric Gauß-Seidel */
+    arguments->num_matrices = (options->precond == PRECOND_SGS) ? 4 : 3;
+  } else if (options->method == METH_JACOBI &&
+             options->precision == PRECISION_MIXED) {
+    /* the float grids of the sweeps are mapped by calculateJacobiMixed() */
+    arguments->num_matrices = 1;
+  } else if (options->method == METH_JACOBI && options->inplace) {
+    arguments->num_matrices = 1;
+  } else if (options->method == METH_JACOBI ||
+             options->method == METH_CHEBYSHEV ||
+             options->method == METH_MULTIGRID) {
+    arguments->num_matrices = 2;
+  } else {
+    arguments->num_matrices = 1;
+  }
+
+  arguments->h = 1.0 / arguments->N;
+  arguments->fpisin_row = NULL;
+  arguments->sin_col = NULL;
+
+  results->m = 0;
+  results->stat_iteration = 0;
+  results->stat_precision = 0;
+}
+
+/* ************************************************************************ */
+/* relaxationFactor: omega of the SOR methods, 1 for all other methods      */
+/* ************************************************************************ */
+static double relaxationFactor(struct options const *options) {
+  if (options->method == METH_SOR || options->method == METH_SOR_RED_BLACK) {
+    return options->omega;
+  }
+
+  return 1.0;
+}
+
+/* ************************************************************************ */
+/* freeMatrices: frees memory for matrices                                  */
+/* ************************************************************************ */
+static void freeMatrices(struct calculation_arguments *arguments) {
+  free(arguments->Matrix);
+  munmap(arguments->M, arguments->M_size);
+  free(arguments->fpisin_row);
+  free(arguments->sin_col);
+}
+
+/* ************************************************************************ */
+/* allocateMemory ()                                                        */
+/* allocates memory and quits if there was a memory allocation problem      */
+/* ************************************************************************ */
+static void *allocateMemory(size_t size) {
+  void *p;
+
+  if ((p = malloc(size)) == NULL) {
+    printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", size);
+    exit(1);
+  }
+
+  return p;
+}
+
+/* ************************************************************************ */
+/* paddedStride: row length in elements of the given size for a matrix      */
+/* with the given number of lines, rounded up to an odd number of cache     */
+/* lines                                                                    */
+/* ************************************************************************ */
+static uint64_t paddedStride(uint64_t lines, size_t element) {
+  uint64_t const per_line = CACHE_LINE / element;
+  uint64_t cache_lines = (lines + per_line - 1) / per_line;
+
+  if (cache_lines % 2 == 0) {
+    cache_lines++;
+  }
+
+  return cache_lines * per_line;
+}
+
+/* ************************************************************************ */
+/* allocateGrid ()                                                          */
+/* maps page-aligned memory for matrices, backed by huge pages if wanted;   */
+/* *size is rounded up to the size actually mapped                          */
+/* ************************************************************************ */
+static void *allocateGrid(size_t *size, uint64_t huge_pages) {
+  void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (huge_pages == HUGE_PAGES_EXPLICIT) {
+    size_t const rounded = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                           HUGE_PAGE_SIZE;
+
+    p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (p != MAP_FAILED) {
+      *size = rounded;
+      return p;
+    }
+  }
+#endif
+
+  p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+           -1, 0);
+
+  if (p == MAP_FAILED) {
+    printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", *size);
+    exit(1);
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (huge_pages != HUGE_PAGES_OFF) {
+    /* only a hint, the matrices work without transparent huge pages */
+    (void)madvise(p, *size, MADV_HUGEPAGE);
+  }
+#endif
+
+  return p;
+}
+
+/* ************************************************************************ */
+/* allocateMatrices: allocates memory for matrices                          */
+/* ************************************************************************ */
+static void allocateMatrices(struct calculation_arguments *arguments,
+                             struct options const *options) {
+  uint64_t i;
+
+  uint64_t const stride = paddedStride(arguments->cols, sizeof(double));
+
+  /* one extra cache line keeps row i of two matrices in different sets */
+  uint64_t const pitch =
+      arguments->rows * stride + CACHE_LINE / sizeof(double);
+
+  arguments->M_size = arguments->num_matrices * pitch * sizeof(double);
+  arguments->M = allocateGrid(&arguments->M_size, options->huge_pages);
+  arguments->Matrix =
+      allocateMemory(arguments->num_matrices * sizeof(struct grid));
+
+  for (i = 0; i < arguments->num_matrices; i++) {
+    arguments->Matrix[i].data = arguments->M + i * pitch;
+    arguments->Matrix[i].stride = stride;
+  }
+}
+
+/* ************************************************************************ */
+/* initMatrices: Initialize matrix/matrices and some global variables       */
+/* ************************************************************************ */
+static void initMatrices(struct calculation_arguments *arguments,
+                         struct options const *options) {
+  uint64_t g, i, j; /* local variables for loops */
+
+  uint64_t const N = arguments->N;
+  uint64_t const rows = arguments->rows;
+  double const h = arguments->h;
+  struct grid const *Matrix = arguments->Matrix;
+
+  /* initialize matrix/matrices with zeros */
+  for (g = 0; g < arguments->num_matrices; g++) {
+    for (i = 0; i < rows; i++) {
+      for (j = 0; j < arguments->cols; j++) {
+        gridRow(&Matrix[g], i)[j] = 0.0;
+      }
+    }
+  }
+
+  /* initialize borders, depending on function (function 2: nothing to do) */
+  if (options->inf_func == FUNC_F0) {
+    for (g = 0; g < arguments->num_matrices; g++) {
+      /* all columns, but possibly only the upper half of the lines */
+      double *const top = gridRow(&Matrix[g], 0);
+      double *const bottom = (rows > N) ? gridRow(&Matrix[g], N) : NULL;
+
+      for (i = 0; i <= N; i++) {
+        if (i < rows) {
+          gridRow(&Matrix[g], i)[0] = 1.0 - (h * i);
+          gridRow(&Matrix[g], i)[N] = h * i;
+        }
+
+        top[i] = 1.0 - (h * i);
+
+        if (bottom != NULL) {
+          bottom[i] = h * i;
+        }
+      }
+
+      if (bottom != NULL) {
+        bottom[0] = 0.0;
+      }
+
+      top[N] = 0.0;
+    }
+  }
+}
+
+/* ************************************************************************ */
+/* initSourceTerm: tabulates the inference function                         */
+/*                                                                          */
+/* f(x,y) = 2pi^2*sin(pi*x)sin(pi*y) is separable, so the term              */
+/* fpisin * sin(pi*h*i) * sin(pi*h*j) added to every element is the         */
+/* product of a row and a column factor. Both are computed once here        */
+/* instead of calling sin() for every element in every iteration.           */
+/* ************************************************************************ */
+static void initSourceTerm(struct calculation_arguments *arguments,
+                           struct options const *options) {
+  uint64_t i;
+
+  uint64_t const N = arguments->N;
+  double const h = arguments->h;
+
+  double const pih = PI * h;
+  double const fpisin = 0.25 * TWO_PI_SQUARE * h * h;
+
+  if (options->inf_func != FUNC_FPISIN) {
+    return;
+  }
+
+  arguments->fpisin_row = allocateMemory((N + 1) * sizeof(double));
+  arguments->sin_col = allocateMemory((N + 1) * sizeof(double));
+
+  for (i = 0; i <= N; i++) {
+    arguments->fpisin_row[i] = fpisin * sin(pih * (double)i);
+    arguments->sin_col[i] = sin(pih * (double)i);
+  }
+}
+
+/* ************************************************************************ */
+/* checkResiduum: whether the given iteration (counted from 1) computes the */
+/* residuum                                                                 */
+/*                                                                          */
+/* With TERM_PREC, only every check_interval-th iteration computes the      */
+/* residuum and may stop the calculation; the others skip the subtraction,  */
+/* the maximum and the reduction. With TERM_ITER, only the last one does.   */
+/* ************************************************************************ */
+static inline int checkResiduum(struct options const *options,
+                                uint64_t iteration, int term_iteration) {
+  if (options->termination == TERM_PREC) {
+    return iteration % options->check_interval == 0;
+  }
+
+  return term_iteration == 1;
+}
+
+/* ************************************************************************ */
+/* updateJacobi: computes one element of the new matrix                     */
+/* ************************************************************************ */
+static inline double updateJacobi(struct grid const *Matrix_Out,
+                                  struct grid const *Matrix_In, int i, int j,
+                                  double fpisin_i, double const *sin_col,
+                                  int check, double maxResiduum) {
+  double residuum;
+
+  double const *above = gridRow(Matrix_In, i - 1);
+  double const *row = gridRow(Matrix_In, i);
+  double const *below = gridRow(Matrix_In, i + 1);
+
+  double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+  if (sin_col != NULL) {
+    star += fpisin_i * sin_col[j];
+  }
+
+  if (check) {
+    residuum = row[j] - star;
+    residuum = (residuum < 0) ? -residuum : residuum;
+    maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+  }
+
+  gridRow(Matrix_Out, i)[j] = star;
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* An asynchronous residuum check: a helper thread computes the residuum    */
+/* max |jacobi(u) - u| of a copy of the matrix while the solver goes on.    */
+/* ************************************************************************ */
+struct residuum_check {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  struct calculation_arguments const *arguments;
+  struct grid snapshot; /* copy of the matrix handed to the helper        */
+  size_t size;          /* bytes mapped for the copy                      */
+  int pending;          /* copy handed over, residuum not yet computed    */
+  int ready;            /* residuum computed, not yet fetched             */
+  int stop;             /* helper shall terminate                         */
+  double residuum;      /* residuum of the last copy                      */
+};
+
+/* ************************************************************************ */
+/* checkResiduumWorker: the helper thread                                   */
+/* ************************************************************************ */
+static void *checkResiduumWorker(void *arg) {
+  struct residuum_check *check = arg;
+
+  int const N = check->arguments->N;
+  double const *fpisin_row = check->arguments->fpisin_row;
+  double const *sin_col = check->arguments->sin_col;
+  struct grid const *snapshot = &check->snapshot;
+
+  jacobi_row_kernel const jacobiRow = selectJacobiRowKernel(sin_col != NULL, 1);
+  double *star = allocateMemory((N + 1) * sizeof(double));
+
+  pthread_mutex_lock(&check->lock);
+
+  while (!check->stop) {
+    double maxResiduum = 0;
+
+    if (!check->pending) {
+      pthread_cond_wait(&check->cond, &check->lock);
+      continue;
+    }
+
+    /* the solver does not touch the copy while it is pending */
+    pthread_mutex_unlock(&check->lock);
+
+    for (int i = 1; i < N; i++) {
+      double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+      maxResiduum = jacobiRow(star, gridRow(snapshot, i - 1),
+                              gridRow(snapshot, i), gridRow(snapshot, i + 1),
+                              sin_col, fpisin_i, N, maxResiduum);
+    }
+
+    pthread_mutex_lock(&check->lock);
+
+    check->residuum = maxResiduum;
+    check->pending = 0;
+    check->ready = 1;
+  }
+
+  pthread_mutex_unlock(&check->lock);
+  free(star);
+
+  return NULL;
+}
+
+/* ************************************************************************ */
+/* startResiduumCheck: maps the copy and starts the helper thread           */
+/* ************************************************************************ */
+static void startResiduumCheck(struct residuum_check *check,
+                               struct calculation_arguments const *arguments,
+                               struct options const *options) {
+  uint64_t const N = arguments->N;
+
+  check->arguments = arguments;
+  check->snapshot.stride = arguments->Matrix[0].stride;
+  check->size = (N + 1) * check->snapshot.stride * sizeof(double);
+  check->snapshot.data = allocateGrid(&check->size, options->huge_pages);
+  check->pending = 0;
+  check->ready = 0;
+  check->stop = 0;
+  check->residuum = 0;
+
+  pthread_mutex_init(&check->lock, NULL);
+  pthread_cond_init(&check->cond, NULL);
+
+  if (pthread_create(&check->thread, NULL, checkResiduumWorker, check) != 0) {
+    printf("Fehler beim Erzeugen des Hilfsthreads!\n");
+    exit(1);
+  }
+}
+
+/* ************************************************************************ */
+/* stopResiduumCheck: waits for the helper thread and frees the copy        */
+/* ************************************************************************ */
+static void stopResiduumCheck(struct residuum_check *check) {
+  pthread_mutex_lock(&check->lock);
+  check->stop = 1;
+  pthread_cond_signal(&check->cond);
+  pthread_mutex_unlock(&check->lock);
+
+  pthread_join(check->thread, NULL);
+
+  pthread_cond_destroy(&check->cond);
+  pthread_mutex_destroy(&check->lock);
+  munmap(check->snapshot.data, check->size);
+}
+
+/* ************************************************************************ */
+/* postResiduumCheck: hands the filled copy to the helper thread            */
+/* ************************************************************************ */
+static void postResiduumCheck(struct residuum_check *check) {
+  pthread_mutex_lock(&check->lock);
+  check->pending = 1;
+  pthread_cond_signal(&check->cond);
+  pthread_mutex_unlock(&check->lock);
+}
+
+/* ************************************************************************ */
+/* pollResiduumCheck: fetches the residuum of the last copy if it is known  */
+/* (returns 1) and tells whether the helper is free for the next copy       */
+/* ************************************************************************ */
+static int pollResiduumCheck(struct residuum_check *check, double *residuum,
+                             int *idle) {
+  int ready;
+
+  pthread_mutex_lock(&check->lock);
+
+  ready = check->ready;
+  check->ready = 0;
+  *residuum = check->residuum;
+  *idle = !check->pending;
+
+  pthread_mutex_unlock(&check->lock);
+
+  return ready;
+}
+
+/* ************************************************************************ */
+/* calculateJacobi: solves the equation with the Jacobi method              */
+/*                                                                          */
+/* All threads stay inside one parallel region for the whole calculation.   */
+/* The work is distributed row-wise (ZEILE, default), column-wise (SPALTE)  */
+/* or element-wise (ELEMENT); the schedule is taken from OMP_SCHEDULE.      */
+/* Row-wise, the rows are computed by the vectorized kernels of stencil.c.  */
+/*                                                                          */
+/* With PARTDIFF_CHECK_ASYNC, the solver never computes the residuum for    */
+/* TERM_PREC: every check_interval iterations, if the helper thread is      */
+/* free, the new matrix is copied and handed over, and the solver stops as  */
+/* soon as the helper reports a residuum below term_precision. The          */
+/* iterations done meanwhile are counted, the precision is the residuum of  */
+/* the copy.                                                                */
+/* ************************************************************************ */
+static void calculateJacobi(struct calculation_arguments const *arguments,
+                            struct calculation_results *results,
+                            struct options const *options) {
+  int m1 = 0, m2 = 1; /* used as indices for old and new matrices */
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+  int snapshot = 0;   /* copy the new matrix for the helper thread      */
+  struct residuum_check residuum_check;
+
+  int const async = (options->termination == TERM_PREC &&
+                     options->check_async == CHECK_ASYNC);
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+
+  int term_iteration = options->term_iteration;
+
+#if !defined(SPALTE) && !defined(ELEMENT)
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(arguments->sin_col != NULL, 0),
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1)};
+#endif
+
+  if (async) {
+    startResiduumCheck(&residuum_check, arguments, options);
+  }
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      struct grid const *Matrix_Out = &arguments->Matrix[m1];
+      struct grid const *Matrix_In = &arguments->Matrix[m2];
+
+      int const check =
+          !async &&
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+      /* read before the single below may change it */
+      int const copy = snapshot;
+
+#if defined(SPALTE)
+      /* over all columns */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int j = 1; j < N; j++) {
+        /* over all rows */
+        for (int i = 1; i < N; i++) {
+          double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+          maxResiduum = updateJacobi(Matrix_Out, Matrix_In, i, j, fpisin_i,
+                                     sin_col, check, maxResiduum);
+        }
+      }
+#elif defined(ELEMENT)
+      /* over all elements */
+#pragma omp for collapse(2) schedule(runtime) reduction(max : maxResiduum)
+      for (int i = 1; i < N; i++) {
+        for (int j = 1; j < N; j++) {
+          double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+          maxResiduum = updateJacobi(Matrix_Out, Matrix_In, i, j, fpisin_i,
+                                     sin_col, check, maxResiduum);
+        }
+      }
+#else
+      /* over all rows */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int i = 1; i < N; i++) {
+        double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+        /* over all columns, as one vector kernel */
+        maxResiduum = jacobiRow[check](
+            gridRow(Matrix_Out, i), gridRow(Matrix_In, i - 1),
+            gridRow(Matrix_In, i), gridRow(Matrix_In, i + 1), sin_col, fpisin_i,
+            N, maxResiduum);
+      }
+#endif
+
+      if (copy) {
+#pragma omp for schedule(runtime)
+        for (int i = 0; i <= N; i++) {
+          memcpy(gridRow(&residuum_check.snapshot, i), gridRow(Matrix_Out, i),
+                 (N + 1) * sizeof(double));
+        }
+      }
+
+      /* one thread does the bookkeeping, the others wait at its barrier */
+#pragma omp single
+      {
+        int tmp;
+
+        results->stat_iteration++;
+
+        if (check) {
+          results->stat_precision = maxResiduum;
+        }
+
+        if (async) {
+          double residuum;
+          int idle;
+
+          if (copy) {
+            postResiduumCheck(&residuum_check);
+          }
+
+          if (pollResiduumCheck(&residuum_check, &residuum, &idle)) {
+            results->stat_precision = residuum;
+
+            if (residuum < options->term_precision) {
+              term_iteration = 0;
+            }
+          }
+
+          /* copy the next matrix due, if the helper is free by then */
+          snapshot = idle && checkResiduum(options, results->stat_iteration + 1,
+                                           term_iteration);
+        }
+
+        /* exchange m1 and m2 */
+        tmp = m1;
+        m1 = m2;
+        m2 = tmp;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
+  }
+
+  if (async) {
+    stopResiduumCheck(&residuum_check);
+  }
+
+  results->m = m2;
+}
+
+/* ************************************************************************ */
+/* calculateJacobiInPlace: solves the equation with the Jacobi method on    */
+/* a single matrix                                                          */
+/*                                                                          */
+/* The rows are cut into one block per thread. Within a block, the new row  */
+/* i is computed into a line buffer and only written back after row i + 1   */
+/* has been computed, so rows i - 1, i and i + 1 are still the old ones     */
+/* when row i is computed. The rows next to a block belong to the blocks    */
+/* of other threads and are copied into two more line buffers before the    */
+/* sweep. With the same kernels and the same old values, the results are    */
+/* identical to calculateJacobi(); the matrix needs half the memory, and    */
+/* the written rows are already in the cache.                               */
+/* ************************************************************************ */
+static void
+calculateJacobiInPlace(struct calculation_arguments const *arguments,
+                       struct calculation_results *results,
+                       struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  int const blocks =
+      ((int)options->number < N - 1) ? (int)options->number : N - 1;
+
+  /* per block: the rows above and below the block and two new rows */
+  double *buffers = allocateMemory(4 * blocks * (N + 1) * sizeof(double));
+
+  int term_iteration = options->term_iteration;
+
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(arguments->sin_col != NULL, 0),
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1)};
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      int const check =
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+      /* save the neighbour rows before any block writes */
+#pragma omp for schedule(static)
+      for (int b = 0; b < blocks; b++) {
+        int const i0 = 1 + (int)((int64_t)b * (N - 1) / blocks);
+        int const i1 = 1 + (int)((int64_t)(b + 1) * (N - 1) / blocks);
+        double *top = buffers + 4 * b * (N + 1);
+        double *bottom = top + (N + 1);
+
+        memcpy(top, gridRow(Matrix, i0 - 1), (N + 1) * sizeof(double));
+        memcpy(bottom, gridRow(Matrix, i1), (N + 1) * sizeof(double));
+      }
+
+#pragma omp for schedule(static) reduction(max : maxResiduum)
+      for (int b = 0; b < blocks; b++) {
+        int const i0 = 1 + (int)((int64_t)b * (N - 1) / blocks);
+        int const i1 = 1 + (int)((int64_t)(b + 1) * (N - 1) / blocks);
+        double const *top = buffers + 4 * b * (N + 1);
+        double const *bottom = top + (N + 1);
+        double *star[2] = {buffers + (4 * b + 2) * (N + 1),
+                           buffers + (4 * b + 3) * (N + 1)};
+
+        for (int i = i0; i < i1; i++) {
+          double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+          double const *above = (i == i0) ? top : gridRow(Matrix, i - 1);
+          double const *below = (i + 1 == i1) ? bottom : gridRow(Matrix, i + 1);
+
+          maxResiduum = jacobiRow[check](star[i % 2], above, gridRow(Matrix, i),
+                                         below, sin_col, fpisin_i, N,
+                                         maxResiduum);
+
+          /* row i - 1 is not needed any more */
+          if (i > i0) {
+            memcpy(gridRow(Matrix, i - 1) + 1, star[(i - 1) % 2] + 1,
+                   (N - 1) * sizeof(double));
+          }
+        }
+
+        memcpy(gridRow(Matrix, i1 - 1) + 1, star[(i1 - 1) % 2] + 1,
+               (N - 1) * sizeof(double));
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
+  }
+
+  free(buffers);
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* calculateJacobiMixed: solves the equation with the Jacobi method, the    */
+/* sweeps in float and the solution in double                               */
+/*                                                                          */
+/* Every MIXED_SWEEPS iterations, the Jacobi correction q = jacobi(u) - u   */
+/* of the double solution is computed in double and rounded to float. The   */
+/* sweeps e = 0.25 * (sum of the neighbours of e) + q run on float grids    */
+/* starting from e = 0, with half the memory traffic and twice the numbers  */
+/* per vector. Since the Jacobi step is affine, u + e after k sweeps is the */
+/* k-th Jacobi iterate of u, up to the float rounding of e; adding e to u   */
+/* in double and computing the next q from u removes that rounding, so the  */
+/* precision reaches term_precision like the double method. The iteration   */
+/* count is the number of sweeps, the precision is the maximum of |q|.      */
+/* ************************************************************************ */
+static void calculateJacobiMixed(struct calculation_arguments const *arguments,
+                                 struct calculation_results *results,
+                                 struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+  int sweeps = 0;     /* number of float sweeps until the next correction */
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  uint64_t const stride = paddedStride(N + 1, sizeof(float));
+  uint64_t const pitch = (N + 1) * stride + CACHE_LINE / sizeof(float);
+
+  /* e, the second sweep matrix of e and q; mapped memory is zero */
+  size_t size = 3 * pitch * sizeof(float);
+  float *const data = allocateGrid(&size, options->huge_pages);
+  struct grid_float const e[2] = {{data, stride}, {data + pitch, stride}};
+  struct grid_float const q = {data + 2 * pitch, stride};
+
+  int term_iteration = options->term_iteration;
+
+  jacobi_row_kernel const jacobiRow =
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1);
+  jacobi_row_kernel_float const jacobiRowFloat = selectJacobiRowKernelFloat();
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    double *star = allocateMemory((N + 1) * sizeof(double));
+
+    while (1) {
+      /* q = jacobi(u) - u in double, e = 0 */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int i = 1; i < N; i++) {
+        double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+        double const *row = gridRow(Matrix, i);
+        float *qrow = gridRowFloat(&q, i);
+        float *erow = gridRowFloat(&e[0], i);
+
+        maxResiduum = jacobiRow(star, gridRow(Matrix, i - 1), row,
+                                gridRow(Matrix, i + 1), sin_col, fpisin_i, N,
+                                maxResiduum);
+
+        for (int j = 1; j < N; j++) {
+          qrow[j] = (float)(star[j] - row[j]);
+          erow[j] = 0.0f;
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_precision = maxResiduum;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC &&
+            maxResiduum < options->term_precision) {
+          term_iteration = 0;
+        }
+
+        sweeps = (term_iteration < MIXED_SWEEPS) ? term_iteration
+                                                 : MIXED_SWEEPS;
+        maxResiduum = 0;
+      }
+
+      if (sweeps == 0) {
+        break;
+      }
+
+      for (int s = 0; s < sweeps; s++) {
+        struct grid_float const *Out = &e[(s + 1) % 2];
+        struct grid_float const *In = &e[s % 2];
+
+#pragma omp for schedule(runtime)
+        for (int i = 1; i < N; i++) {
+          jacobiRowFloat(gridRowFloat(Out, i), gridRowFloat(In, i - 1),
+                         gridRowFloat(In, i), gridRowFloat(In, i + 1),
+                         gridRowFloat(&q, i), N);
+        }
+      }
+
+      /* u += e in double */
+#pragma omp for schedule(runtime)
+      for (int i = 1; i < N; i++) {
+        double *row = gridRow(Matrix, i);
+        float const *erow = gridRowFloat(&e[sweeps % 2], i);
+
+        for (int j = 1; j < N; j++) {
+          row[j] += erow[j];
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration += sweeps;
+
+        if (options->termination == TERM_ITER) {
+          term_iteration -= sweeps;
+        }
+      }
+    }
+
+    free(star);
+  }
+
+  munmap(data, size);
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* updateJacobiRows: computes the rows [i0, i1) of the new matrix           */
+/* ************************************************************************ */
+static inline double updateJacobiRows(struct grid const *Matrix_Out,
+                                      struct grid const *Matrix_In, int i0,
+                                      int i1, int N,
+                                      jacobi_row_kernel const jacobiRow[2],
+                                      double const *fpisin_row,
+                                      double const *sin_col, int check,
+                                      double maxResiduum) {
+  for (int i = i0; i < i1; i++) {
+    double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+    maxResiduum = jacobiRow[check](gridRow(Matrix_Out, i),
+                                   gridRow(Matrix_In, i - 1),
+                                   gridRow(Matrix_In, i),
+                                   gridRow(Matrix_In, i + 1), sin_col, fpisin_i,
+                                   N, maxResiduum);
+  }
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculateJacobiTimeBlocked: solves the equation with the Jacobi method,  */
+/* advancing each tile of rows by several iterations at once                */
+/*                                                                          */
+/* Only for TERM_ITER. The rows are cut into tiles of at least              */
+/* 2 * time_depth rows, or a single tile of all rows if the matrix has      */
+/* fewer. For T = time_depth iterations, every tile first                   */
+/* computes a trapezoid that shrinks by one row per iteration at each inner */
+/* tile border; then the inverted trapezoids around the borders are filled  */
+/* in. Both phases stay in cache for T iterations instead of streaming the  */
+/* matrices once per iteration, and since no row is needed again after it   */
+/* has been overwritten two iterations later, the two matrices are enough.  */
+/* The results are identical to calculateJacobi().                          */
+/* ************************************************************************ */
+static void
+calculateJacobiTimeBlocked(struct calculation_arguments const *arguments,
+                           struct calculation_results *results,
+                           struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+
+  int const depth = options->time_depth;
+
+  /* min(max(tile_size, 2 * depth), N - 1), computed before the cast */
+  uint64_t rows = options->tile_size;
+
+  rows = (rows < 2 * options->time_depth) ? 2 * options->time_depth : rows;
+  rows = (rows < (uint64_t)(N - 1)) ? rows : (uint64_t)(N - 1);
+
+  int const height = (int)rows;
+  int const tiles = (N - 1 + height - 1) / height;
+
+  int const term_iteration = options->term_iteration;
+  int iteration = 0; /* iterations finished by all rows */
+
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(arguments->sin_col != NULL, 0),
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1)};
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (iteration < term_iteration) {
+      int const steps = (term_iteration - iteration < depth)
+                            ? term_iteration - iteration
+                            : depth;
+
+      /* trapezoids; iteration t is read from Matrix[t % 2] */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int tile = 0; tile < tiles; tile++) {
+        int const r0 = 1 + tile * height;
+        int const r1 = (r0 + height < N) ? r0 + height : N;
+
+        for (int s = 1; s <= steps; s++) {
+          int const t = iteration + s;
+          int const i0 = (tile == 0) ? r0 : r0 + s;
+          int const i1 = (tile == tiles - 1) ? r1 : r1 - s;
+
+          maxResiduum = updateJacobiRows(
+              &arguments->Matrix[(t + 1) % 2], &arguments->Matrix[t % 2], i0, i1,
+              N, jacobiRow, arguments->fpisin_row, arguments->sin_col,
+              t == term_iteration,
+              maxResiduum);
+        }
+      }
+
+      /* inverted trapezoids around the inner tile borders */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int tile = 1; tile < tiles; tile++) {
+        int const r0 = 1 + tile * height;
+
+        for (int s = 1; s <= steps; s++) {
+          int const t = iteration + s;
+
+          maxResiduum = updateJacobiRows(
+              &arguments->Matrix[(t + 1) % 2], &arguments->Matrix[t % 2], r0 - s,
+              r0 + s < N ? r0 + s : N, N, jacobiRow, arguments->fpisin_row,
+              arguments->sin_col,
+              t == term_iteration, maxResiduum);
+        }
+      }
+
+#pragma omp single
+      iteration += steps;
+    }
+  }
+
+  results->stat_iteration = iteration;
+  results->stat_precision = maxResiduum;
+  results->m = (iteration + 1) % 2;
+}
+
+/* ************************************************************************ */
+/* calculateChebyshev: solves the equation with the Jacobi method,          */
+/* accelerated by Chebyshev polynomials                                     */
+/*                                                                          */
+/* The eigenvalues of the Jacobi iteration of the model problem lie in      */
+/* [-rho, rho] with rho = cos(pi * h), which gives the weights              */
+/* omega(1) = 1, omega(2) = 1 / (1 - rho^2 / 2) and                         */
+/* omega(k+1) = 1 / (1 - rho^2 * omega(k) / 4). Every thread computes the   */
+/* Jacobi step of a row with the kernels of stencil.c into its own row      */
+/* buffer. u(k+1) only needs u(k-1) at the same element, so it overwrites   */
+/* u(k-1) and the two matrices m1/m2 of the Jacobi method are enough.       */
+/* ************************************************************************ */
+static void calculateChebyshev(struct calculation_arguments const *arguments,
+                               struct calculation_results *results,
+                               struct options const *options) {
+  int m1 = 0, m2 = 1; /* used as indices for old and new matrices */
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+
+  double const rho = cos(PI * arguments->h);
+  double omega = 1.0;
+
+  int term_iteration = options->term_iteration;
+
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(arguments->sin_col != NULL, 0),
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1)};
+
+  /* both matrices start as u(0); the first step is a plain Jacobi step */
+  for (int i = 1; i < N; i++) {
+    for (int j = 1; j < N; j++) {
+      gridRow(&arguments->Matrix[m1], i)[j] =
+          gridRow(&arguments->Matrix[m2], i)[j];
+    }
+  }
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    double *star = allocateMemory((N + 1) * sizeof(double));
+
+    while (term_iteration > 0) {
+      struct grid const *Matrix_Out = &arguments->Matrix[m1];
+      struct grid const *Matrix_In = &arguments->Matrix[m2];
+
+      int const check =
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+      for (int i = 1; i < N; i++) {
+        double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+        double *out = gridRow(Matrix_Out, i);
+
+        maxResiduum = jacobiRow[check](
+            star, gridRow(Matrix_In, i - 1), gridRow(Matrix_In, i),
+            gridRow(Matrix_In, i + 1), sin_col, fpisin_i, N, maxResiduum);
+
+        /* u(k+1) = u(k-1) + omega * (jacobi(u(k)) - u(k-1)) */
+        for (int j = 1; j < N; j++) {
+          out[j] += omega * (star[j] - out[j]);
+        }
+      }
+
+#pragma omp single
+      {
+        int tmp;
+
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        omega = (results->stat_iteration == 1)
+                    ? 1.0 / (1.0 - 0.5 * rho * rho)
+                    : 1.0 / (1.0 - 0.25 * rho * rho * omega);
+
+        /* exchange m1 and m2 */
+        tmp = m1;
+        m1 = m2;
+        m2 = tmp;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
+
+    free(star);
+  }
+
+  results->m = m2;
+}
+
+/* ************************************************************************ */
+/* sweepRow: updates the elements first, first + step, ... < last of one    */
+/* row in place, in natural order                                           */
+/*                                                                          */
+/* step, source, check and relax are constants in each instance below, so   */
+/* the inference function, the residuum and the over-relaxation are only   */
+/* compiled into the loops that need them.                                  */
+/* ************************************************************************ */
+__attribute__((always_inline)) static inline double
+sweepRow(double *restrict row, double const *restrict above,
+         double const *restrict below, int first, int last, double fpisin_i,
+         double const *restrict sin_col, double omega, double maxResiduum,
+         int const step, int const source, int const check, int const relax) {
+  for (int j = first; j < last; j += step) {
+    double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+    if (source) {
+      star += fpisin_i * sin_col[j];
+    }
+
+    if (check) {
+      double residuum = row[j] - star;
+      residuum = (residuum < 0) ? -residuum : residuum;
+      maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+    }
+
+    /* over-relaxation; omega = 1 is plain Gauß-Seidel */
+    if (relax) {
+      star = row[j] + omega * (star - row[j]);
+    }
+
+    row[j] = star;
+  }
+
+  return maxResiduum;
+}
+
+typedef double (*row_kernel)(double *restrict, double const *restrict,
+                             double const *restrict, int, int, double,
+                             double const *restrict, double, double);
+
+#define ROW_KERNEL(step, source, check, relax)                                 \
+  static double sweepRow##step##source##check##relax(                          \
+      double *restrict row, double const *restrict above,                      \
+      double const *restrict below, int first, int last, double fpisin_i,      \
+      double const *restrict sin_col, double omega, double maxResiduum) {      \
+    return sweepRow(row, above, below, first, last, fpisin_i, sin_col, omega,  \
+                    maxResiduum, step, source, check, relax);                  \
+  }
+
+#define ROW_KERNELS(step)                                                      \
+  ROW_KERNEL(step, 0, 0, 0)                                                    \
+  ROW_KERNEL(step, 0, 0, 1)                                                    \
+  ROW_KERNEL(step, 0, 1, 0)                                                    \
+  ROW_KERNEL(step, 0, 1, 1)                                                    \
+  ROW_KERNEL(step, 1, 0, 0)                                                    \
+  ROW_KERNEL(step, 1, 0, 1)                                                    \
+  ROW_KERNEL(step, 1, 1, 0)                                                    \
+  ROW_KERNEL(step, 1, 1, 1)
+
+ROW_KERNELS(1)
+ROW_KERNELS(2)
+
+/* [step - 1][source][check][relax] */
+static row_kernel const rowKernels[2][2][2][2] = {
+    {{{sweepRow1000, sweepRow1001}, {sweepRow1010, sweepRow1011}},
+     {{sweepRow1100, sweepRow1101}, {sweepRow1110, sweepRow1111}}},
+    {{{sweepRow2000, sweepRow2001}, {sweepRow2010, sweepRow2011}},
+     {{sweepRow2100, sweepRow2101}, {sweepRow2110, sweepRow2111}}}};
+
+/* ************************************************************************ */
+/* selectRowKernel: returns the instance of sweepRow for every step-th      */
+/* element, the inference function given by sin_col, check and omega        */
+/* ************************************************************************ */
+static inline row_kernel selectRowKernel(int step, double const *sin_col,
+                                         int check, double omega) {
+  return rowKernels[step - 1][sin_col != NULL][check != 0][omega != 1.0];
+}
+
+/* ************************************************************************ */
+/* calculateGaussSeidel: solves the equation with the Gauss-Seidel method   */
+/* or, for omega != 1, with successive over-relaxation (SOR)                */
+/* ************************************************************************ */
+static void calculateGaussSeidel(struct calculation_arguments const *arguments,
+                                 struct calculation_results *results,
+                                 struct options const *options) {
+  int i;              /* local variable for loops */
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+  int term_iteration = options->term_iteration;
+
+  double const omega = relaxationFactor(options);
+
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+
+  /* one row kernel per value of check */
+  row_kernel const sweep[2] = {selectRowKernel(1, sin_col, 0, omega),
+                               selectRowKernel(1, sin_col, 1, omega)};
+
+  while (term_iteration > 0) {
+    int const check =
+        checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+    maxResiduum = 0;
+
+    /* over all rows */
+    for (i = 1; i < N; i++) {
+      double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+      /* over all columns */
+      maxResiduum = sweep[check](gridRow(Matrix, i), gridRow(Matrix, i - 1),
+                                 gridRow(Matrix, i + 1), 1, N, fpisin_i,
+                                 sin_col, omega, maxResiduum);
+    }
+
+    results->stat_iteration++;
+    results->stat_precision = maxResiduum;
+
+    /* check for stopping calculation depending on termination method */
+    if (options->termination == TERM_PREC) {
+      if (check && maxResiduum < options->term_precision) {
+        term_iteration = 0;
+      }
+    } else if (options->termination == TERM_ITER) {
+      term_iteration--;
+    }
+  }
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* sweepGaussSeidelTile: updates the rows [i0, i1) and columns [j0, j1) in  */
+/* natural order                                                            */
+/* ************************************************************************ */
+static inline double sweepGaussSeidelTile(struct grid const *Matrix, int i0,
+                                          int i1, int j0, int j1,
+                                          double const *fpisin_row,
+                                          double const *sin_col, double omega,
+                                          int check, double maxResiduum) {
+  row_kernel const sweep = selectRowKernel(1, sin_col, check, omega);
+
+  for (int i = i0; i < i1; i++) {
+    double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+    maxResiduum = sweep(gridRow(Matrix, i), gridRow(Matrix, i - 1),
+                        gridRow(Matrix, i + 1), j0, j1, fpisin_i, sin_col,
+                        omega, maxResiduum);
+  }
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* calculateGaussSeidelWavefront: solves the equation with the Gauss-Seidel */
+/* method on all threads                                                    */
+/*                                                                          */
+/* The matrix is cut into tiles of tile_size x tile_size elements. Tile     */
+/* (I, J) needs the new values of tiles (I-1, J) and (I, J-1) and the old   */
+/* ones of (I+1, J) and (I, J+1), so all tiles on one anti-diagonal         */
+/* I + J = d can run concurrently. Every element sees exactly the values    */
+/* of the sequential loop, so the results are bit-identical to it.          */
+/* ************************************************************************ */
+static void
+calculateGaussSeidelWavefront(struct calculation_arguments const *arguments,
+                              struct calculation_results *results,
+                              struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+
+  /* at most the whole matrix, so the tile arithmetic stays within int */
+  int const tile = (options->tile_size < (uint64_t)(N - 1))
+                       ? (int)options->tile_size
+                       : N - 1;
+  int const tiles = (N - 1 + tile - 1) / tile; /* tiles per dimension */
+
+  int term_iteration = options->term_iteration;
+
+  double const omega = relaxationFactor(options);
+
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      int const check =
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+      /* over all anti-diagonals of tiles */
+      for (int d = 0; d < 2 * tiles - 1; d++) {
+        int const first = (d < tiles) ? 0 : d - tiles + 1;
+        int const last = (d < tiles) ? d : tiles - 1;
+
+        /* over all tiles of the front; omp for ends with a barrier */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+        for (int I = first; I <= last; I++) {
+          int const J = d - I;
+          int const i0 = 1 + I * tile;
+          int const j0 = 1 + J * tile;
+          int const i1 = (i0 + tile < N) ? i0 + tile : N;
+          int const j1 = (j0 + tile < N) ? j0 + tile : N;
+
+          maxResiduum =
+              sweepGaussSeidelTile(Matrix, i0, i1, j0, j1, arguments->fpisin_row,
+                                   arguments->sin_col, omega, check,
+                                   maxResiduum);
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
+  }
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* sweepRedBlackRow: updates all elements of one color in row i             */
+/*                                                                          */
+/* An element only has neighbours of the other color, so the elements of    */
+/* one color do not depend on each other and the loop can be vectorized.    */
+/* ************************************************************************ */
+static inline double sweepRedBlackRow(double *restrict row,
+                                      double const *restrict above,
+                                      double const *restrict below, int first,
+                                      int N, double fpisin_i,
+                                      double const *sin_col, double omega,
+                                      int check, double maxResiduum) {
+  return selectRowKernel(2, sin_col, check, omega)(
+      row, above, below, first, N, fpisin_i, sin_col, omega, maxResiduum);
+}
+
+/* ************************************************************************ */
+/* calculateRedBlack: solves the equation with the Gauss-Seidel or the SOR  */
+/* method, visiting the elements in red-black (checkerboard) order          */
+/*                                                                          */
+/* Element (i, j) is red if i + j is even. All red elements are updated     */
+/* first, then all black elements with the new red values.                  */
+/* ************************************************************************ */
+static void calculateRedBlack(struct calculation_arguments const *arguments,
+                              struct calculation_results *results,
+                              struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+
+  int const N = arguments->N;
+  int term_iteration = options->term_iteration;
+
+  double const omega = relaxationFactor(options);
+
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      int const check =
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+      for (int color = 0; color < 2; color++) {
+        /* over all rows; the barrier of omp for separates the colors */
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+        for (int i = 1; i < N; i++) {
+          double const fpisin_i =
+              (arguments->sin_col != NULL) ? arguments->fpisin_row[i] : 0.0;
+
+          maxResiduum = sweepRedBlackRow(
+              gridRow(Matrix, i), gridRow(Matrix, i - 1), gridRow(Matrix, i + 1),
+              1 + ((i + 1 + color) & 1), N, fpisin_i, arguments->sin_col, omega,
+              check, maxResiduum);
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
+  }
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* sweepGaussSeidelRow: updates row i in natural order                      */
+/* ************************************************************************ */
+static inline double sweepGaussSeidelRow(double *restrict row,
+                                         double const *restrict above,
+                                         double const *restrict below, int N,
+                                         double fpisin_i, double const *sin_col,
+                                         double omega, int check,
+                                         double maxResiduum) {
+  return selectRowKernel(1, sin_col, check, omega)(
+      row, above, below, 1, N, fpisin_i, sin_col, omega, maxResiduum);
+}
+
+/* ************************************************************************ */
+/* State of the band of rows of one thread in the asynchronous mode         */
+/* ************************************************************************ */
+struct band_state {
+  _Alignas(CACHE_LINE) _Atomic uint64_t sweeps; /* finished sweeps          */
+  _Atomic uint64_t seen[2]; /* sweeps of the bands above and below before   */
+                            /* the last checked sweep                       */
+  atomic_int converged;     /* residuum of the last checked sweep is small  */
+  double precision;         /* residuum of the last checked sweep           */
+};
+
+/* ************************************************************************ */
+/* loadRow, storeRow: copy a row that another thread accesses at the same   */
+/* time, element by element with relaxed atomics                            */
+/* ************************************************************************ */
+static inline void loadRow(double *dst, double *src, int N) {
+  for (int j = 0; j <= N; j++) {
+    __atomic_load(&src[j], &dst[j], __ATOMIC_RELAXED);
+  }
+}
+
+static inline void storeRow(double *dst, double *src, int N) {
+  for (int j = 1; j < N; j++) {
+    __atomic_store(&dst[j], &src[j], __ATOMIC_RELAXED);
+  }
+}
+
+/* ************************************************************************ */
+/* sweepBand: one Gauß-Seidel (SOR) sweep over the rows [i0, i1) without    */
+/* waiting for the neighbouring bands                                       */
+/*                                                                          */
+/* The first and the last row of the band are read by the neighbours, the   */
+/* rows next to the band are written by them. These four rows go through    */
+/* relaxed atomics and three line buffers; the rows inside the band are     */
+/* updated in place as usual.                                               */
+/* ************************************************************************ */
+static double sweepBand(struct calculation_arguments const *arguments, int i0,
+                        int i1, double *lines, double omega, int check) {
+  double maxResiduum = 0;
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  double *above_band = lines;
+  double *below_band = lines + (N + 1);
+  double *line = lines + 2 * (N + 1);
+
+  loadRow(above_band, gridRow(Matrix, i0 - 1), N);
+
+  for (int i = i0; i < i1; i++) {
+    double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+    double const *above = (i == i0) ? above_band : gridRow(Matrix, i - 1);
+    double const *below = gridRow(Matrix, i + 1);
+
+    /* as late as possible, to see the newest values */
+    if (i == i1 - 1) {
+      loadRow(below_band, gridRow(Matrix, i1), N);
+      below = below_band;
+    }
+
+    if (i == i0 || i == i1 - 1) {
+      memcpy(line, gridRow(Matrix, i), (N + 1) * sizeof(double));
+
+      maxResiduum = sweepGaussSeidelRow(line, above, below, N, fpisin_i,
+                                        sin_col, omega, check, maxResiduum);
+
+      storeRow(gridRow(Matrix, i), line, N);
+    } else {
+      maxResiduum =
+          sweepGaussSeidelRow(gridRow(Matrix, i), above, below, N, fpisin_i,
+                              sin_col, omega, check, maxResiduum);
+    }
+  }
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* bandsConverged: whether the last residuum of every band is small enough  */
+/*                                                                          */
+/* A band that computed its residuum long ago, against rows its neighbours  */
+/* have changed since, proves nothing: a thread that gets the CPU to itself */
+/* quickly converges its band to the frozen rows of the others. A residuum  */
+/* only counts if the neighbours have finished at most one sweep since,     */
+/* and that sweep changed their rows by less than term_precision.           */
+/* ************************************************************************ */
+static int bandsConverged(struct band_state *bands, int num_bands) {
+  for (int b = 0; b < num_bands; b++) {
+    if (!atomic_load_explicit(&bands[b].converged, memory_order_relaxed)) {
+      return 0;
+    }
+
+    for (int side = 0; side < 2; side++) {
+      int const n = (side == 0) ? b - 1 : b + 1;
+
+      if (n < 0 || n >= num_bands) {
+        continue;
+      }
+
+      if (atomic_load_explicit(&bands[n].sweeps, memory_order_relaxed) >
+          atomic_load_explicit(&bands[b].seen[side], memory_order_relaxed) +
+              1) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* ************************************************************************ */
+/* neighbourSweeps: finished sweeps of band n, 0 if there is no such band   */
+/* ************************************************************************ */
+static inline uint64_t neighbourSweeps(struct band_state *bands, int n,
+                                       int num_bands) {
+  if (n < 0 || n >= num_bands) {
+    return 0;
+  }
+
+  return atomic_load_explicit(&bands[n].sweeps, memory_order_relaxed);
+}
+
+/* ************************************************************************ */
+/* calculateAsync: solves the equation with the Gauß-Seidel or the SOR      */
+/* method without barriers (asynchronous or chaotic relaxation)             */
+/*                                                                          */
+/* Every thread sweeps its band of rows again and again with sweepBand(),   */
+/* reading the rows of its neighbours as they are at that moment. For this  */
+/* diagonally dominant problem the iteration converges all the same, and    */
+/* no thread ever waits for a slower one. With TERM_PREC, each band flags   */
+/* whether its last residuum is below term_precision; the first thread to   */
+/* find all flags set and recent (see bandsConverged()) ends the            */
+/* calculation. The iteration count is the highest number of sweeps of a    */
+/* band, the precision the highest last residuum.                           */
+/* ************************************************************************ */
+static void calculateAsync(struct calculation_arguments const *arguments,
+                           struct calculation_results *results,
+                           struct options const *options) {
+  int const N = arguments->N;
+  int num_bands = 1;
+  atomic_int done;
+
+  double const omega = relaxationFactor(options);
+
+  struct band_state *bands =
+      aligned_alloc(CACHE_LINE, options->number * sizeof(*bands));
+
+  if (bands == NULL) {
+    printf("Speicherprobleme!\n");
+    exit(1);
+  }
+
+  for (uint64_t b = 0; b < options->number; b++) {
+    bands[b].precision = 0;
+    atomic_init(&bands[b].sweeps, 0);
+    atomic_init(&bands[b].seen[0], 0);
+    atomic_init(&bands[b].seen[1], 0);
+    atomic_init(&bands[b].converged, 0);
+  }
+
+  atomic_init(&done, 0);
+
+#pragma omp parallel
+  {
+#ifdef _OPENMP
+    int const b = omp_get_thread_num();
+    int const threads = omp_get_num_threads();
+#else
+    int const b = 0;
+    int const threads = 1;
+#endif
+
+    int const i0 = 1 + (int)((int64_t)b * (N - 1) / threads);
+    int const i1 = 1 + (int)((int64_t)(b + 1) * (N - 1) / threads);
+
+    double *lines = allocateMemory(3 * (N + 1) * sizeof(double));
+    uint64_t sweeps = 0;
+
+    if (b == 0) {
+      num_bands = threads;
+    }
+
+    /* an empty band has nothing to do */
+    atomic_store_explicit(&bands[b].converged, i0 == i1, memory_order_relaxed);
+
+    while (i0 < i1) {
+      uint64_t const above = neighbourSweeps(bands, b - 1, threads);
+      uint64_t const below = neighbourSweeps(bands, b + 1, threads);
+      double maxResiduum;
+      int check;
+
+      if (options->termination == TERM_ITER) {
+        if (sweeps == options->term_iteration) {
+          break;
+        }
+      } else if (atomic_load_explicit(&done, memory_order_acquire)) {
+        break;
+      }
+
+      check = checkResiduum(options, sweeps + 1,
+                            (int)(options->term_iteration - sweeps));
+      maxResiduum = sweepBand(arguments, i0, i1, lines, omega, check);
+      sweeps++;
+
+      if (check) {
+        bands[b].precision = maxResiduum;
+        atomic_store_explicit(&bands[b].seen[0], above, memory_order_relaxed);
+        atomic_store_explicit(&bands[b].seen[1], below, memory_order_relaxed);
+        atomic_store_explicit(&bands[b].converged,
+                              maxResiduum < options->term_precision,
+                              memory_order_relaxed);
+      }
+
+      atomic_store_explicit(&bands[b].sweeps, sweeps, memory_order_relaxed);
+
+      if (check && options->termination == TERM_PREC &&
+          maxResiduum < options->term_precision &&
+          bandsConverged(bands, threads)) {
+        atomic_store_explicit(&done, 1, memory_order_release);
+      }
+
+      /* with more threads than cores, let the neighbours catch up */
+      sched_yield();
+    }
+
+    free(lines);
+  }
+
+  results->stat_iteration = 0;
+  results->stat_precision = 0;
+
+  for (int b = 0; b < num_bands; b++) {
+    uint64_t const sweeps = atomic_load(&bands[b].sweeps);
+
+    if (sweeps > results->stat_iteration) {
+      results->stat_iteration = sweeps;
+    }
+
+    if (bands[b].precision > results->stat_precision) {
+      results->stat_precision = bands[b].precision;
+    }
+  }
+
+  free(bands);
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* One level of the multigrid hierarchy. Level 0 is the matrix itself and   */
+/* takes its right-hand side from the tabulated inference function; every   */
+/* coarser level solves for the correction of the next finer one.           */
+/* ************************************************************************ */
+struct multigrid_level {
+  int N;         /* number of spaces between lines on this level          */
+  struct grid u; /* solution (level 0) or correction (coarser levels)     */
+  struct grid b; /* right-hand side h^2 * f, unused on level 0            */
+  size_t size;   /* bytes mapped for u and b                              */
+};
+
+/* ************************************************************************ */
+/* levelSource: source term of row i, added to star as fpisin_i * source[j] */
+/* ************************************************************************ */
+static inline double const *
+levelSource(struct multigrid_level const *level,
+            struct calculation_arguments const *arguments, int i,
+            double *fpisin_i) {
+  if (level->b.data == NULL) {
+    *fpisin_i = (arguments->sin_col != NULL) ? arguments->fpisin_row[i] : 0.0;
+    return arguments->sin_col;
+  }
+
+  /* 4 * star = sum of the neighbours + b */
+  *fpisin_i = 0.25;
+  return gridRow(&level->b, i);
+}
+
+/* ************************************************************************ */
+/* smoothLevel: red-black Gauß-Seidel/SOR sweeps on one level               */
+/*                                                                          */
+/* Like all multigrid functions, it is called by every thread of the team.  */
 /* ************************************************************************ */
-
-/* time measurement variables */
-struct timeval start_time; /* time when program started                      */
-struct timeval comp_time;  /* time when calculation completed                */
+static void smoothLevel(struct multigrid_level const *level,
+                        struct calculation_arguments const *arguments,
+                        int sweeps, double omega) {
+  int const N = level->N;
+
+  for (int s = 0; s < sweeps; s++) {
+    for (int color = 0; color < 2; color++) {
+#pragma omp for schedule(runtime)
+      for (int i = 1; i < N; i++) {
+        double fpisin_i;
+        double const *source = levelSource(level, arguments, i, &fpisin_i);
+
+        sweepRedBlackRow(gridRow(&level->u, i), gridRow(&level->u, i - 1),
+                         gridRow(&level->u, i + 1), 1 + ((i + 1 + color) & 1),
+                         N, fpisin_i, source, omega, 0, 0.0);
+      }
+    }
+  }
+}
 
 /* ************************************************************************ */
-/* initVariables: Initializes some global variables                         */
+/* coarsePosition: position of line i of a level with N spaces on the next  */
+/* coarser level with Nc spaces, as line J plus a fraction w of a space     */
 /* ************************************************************************ */
-static void initVariables(struct calculation_arguments *arguments,
-                          struct calculation_results *results,
-                          struct options const *options) {
-  arguments->N = (options->interlines * 8) + 9 - 1;
-  arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
-  arguments->h = 1.0 / arguments->N;
+static inline int coarsePosition(int i, int N, int Nc, double *w) {
+  int const J = (int)(((int64_t)i * Nc) / N);
 
-  results->m = 0;
-  results->stat_iteration = 0;
-  results->stat_precision = 0;
+  *w = (double)((int64_t)i * Nc - (int64_t)J * N) / N;
+  return J;
 }
 
 /* ************************************************************************ */
-/* freeMatrices: frees memory for matrices                                  */
+/* restrictInterpolated: right-hand side of a coarser level whose lines are */
+/* not lines of the finer level (odd N, see calculateMultigrid)             */
+/*                                                                          */
+/* The restriction is the transpose of the bilinear interpolation in        */
+/* prolongateInterpolated. For Nc = N / 2 it is the full weighting below    */
+/* times (2h)^2 / h^2 = 4, in general it is about (h_c / h)^2 times a       */
+/* weighted mean, as the coarse equation needs.                             */
 /* ************************************************************************ */
-static void freeMatrices(struct calculation_arguments *arguments) {
-  uint64_t i;
+static void restrictInterpolated(struct multigrid_level const *fine,
+                                 struct multigrid_level const *coarse,
+                                 struct grid const *residuum) {
+  int const N = fine->N;
+  int const Nc = coarse->N;
+
+#pragma omp for schedule(runtime)
+  for (int I = 1; I < Nc; I++) {
+    /* the fine lines strictly between the coarse lines I - 1 and I + 1 */
+    int const i0 = (int)(((int64_t)(I - 1) * N) / Nc) + 1;
+    int const i1 = (int)(((int64_t)(I + 1) * N - 1) / Nc);
+    double *b = gridRow(&coarse->b, I);
+    double *u = gridRow(&coarse->u, I);
+
+    for (int J = 1; J < Nc; J++) {
+      int const j0 = (int)(((int64_t)(J - 1) * N) / Nc) + 1;
+      int const j1 = (int)(((int64_t)(J + 1) * N - 1) / Nc);
+      double sum = 0.0;
+
+      for (int i = i0; i <= i1 && i < N; i++) {
+        double const *r = gridRow(residuum, i);
+        double const wi =
+            1.0 - (double)llabs((int64_t)i * Nc - (int64_t)I * N) / N;
+        double row = 0.0;
+
+        for (int j = j0; j <= j1 && j < N; j++) {
+          double const wj =
+              1.0 - (double)llabs((int64_t)j * Nc - (int64_t)J * N) / N;
+
+          row += wj * r[j];
+        }
 
-  for (i = 0; i < arguments->num_matrices; i++) {
-    free(arguments->Matrix[i]);
+        sum += wi * row;
+      }
+
+      b[J] = sum;
+      u[J] = 0.0;
+    }
   }
+}
 
-  free(arguments->Matrix);
-  free(arguments->M);
+/* ************************************************************************ */
+/* prolongateInterpolated: adds the bilinearly interpolated correction of a */
+/* coarser level whose lines are not lines of the finer level               */
+/* ************************************************************************ */
+static void prolongateInterpolated(struct multigrid_level const *coarse,
+                                   struct multigrid_level const *fine) {
+  int const N = fine->N;
+  int const Nc = coarse->N;
+
+#pragma omp for schedule(runtime)
+  for (int i = 1; i < N; i++) {
+    double wi;
+    int const I = coarsePosition(i, N, Nc, &wi);
+    double const *e0 = gridRow(&coarse->u, I);
+    double const *e1 = gridRow(&coarse->u, I + 1);
+    double *u = gridRow(&fine->u, i);
+
+    for (int j = 1; j < N; j++) {
+      double wj;
+      int const J = coarsePosition(j, N, Nc, &wj);
+
+      u[j] += (1.0 - wi) * ((1.0 - wj) * e0[J] + wj * e0[J + 1]) +
+              wi * ((1.0 - wj) * e1[J] + wj * e1[J + 1]);
+    }
+  }
 }
 
 /* ************************************************************************ */
-/* allocateMemory ()                                                        */
-/* allocates memory and quits if there was a memory allocation problem      */
+/* restrictResidual: computes the residuum of a level and restricts it by   */
+/* full weighting to the right-hand side of the next coarser level, whose   */
+/* correction starts at zero                                                */
 /* ************************************************************************ */
-static void *allocateMemory(size_t size) {
-  void *p;
+static void restrictResidual(struct multigrid_level const *fine,
+                             struct multigrid_level const *coarse,
+                             struct grid const *residuum,
+                             struct calculation_arguments const *arguments) {
+  int const N = fine->N;
+
+  /* residuum b - (4u - sum of the neighbours) = 4 * (star - u) */
+#pragma omp for schedule(runtime)
+  for (int i = 1; i < N; i++) {
+    double fpisin_i;
+    double const *source = levelSource(fine, arguments, i, &fpisin_i);
+
+    double const *above = gridRow(&fine->u, i - 1);
+    double const *row = gridRow(&fine->u, i);
+    double const *below = gridRow(&fine->u, i + 1);
+    double *r = gridRow(residuum, i);
+
+    for (int j = 1; j < N; j++) {
+      double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+      if (source != NULL) {
+        star += fpisin_i * source[j];
+      }
 
-  if ((p = malloc(size)) == NULL) {
-    printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", size);
-    exit(1);
+      r[j] = 4.0 * (star - row[j]);
+    }
   }
 
-  return p;
+  if (coarse->N * 2 != N) {
+    restrictInterpolated(fine, coarse, residuum);
+    return;
+  }
+
+  /* the coarse right-hand side is (2h)^2 times the restricted residuum */
+#pragma omp for schedule(runtime)
+  for (int I = 1; I < coarse->N; I++) {
+    double const *above = gridRow(residuum, 2 * I - 1);
+    double const *row = gridRow(residuum, 2 * I);
+    double const *below = gridRow(residuum, 2 * I + 1);
+    double *b = gridRow(&coarse->b, I);
+    double *u = gridRow(&coarse->u, I);
+
+    for (int J = 1; J < coarse->N; J++) {
+      int const j = 2 * J;
+
+      b[J] = 0.25 * (4.0 * row[j] +
+                     2.0 * (above[j] + below[j] + row[j - 1] + row[j + 1]) +
+                     above[j - 1] + above[j + 1] + below[j - 1] + below[j + 1]);
+      u[J] = 0.0;
+    }
+  }
 }
 
 /* ************************************************************************ */
-/* allocateMatrices: allocates memory for matrices                          */
+/* prolongate: adds the bilinearly interpolated correction of the coarse    */
+/* level to the fine level                                                  */
 /* ************************************************************************ */
-static void allocateMatrices(struct calculation_arguments *arguments) {
-  uint64_t i, j;
+static void prolongate(struct multigrid_level const *coarse,
+                       struct multigrid_level const *fine) {
+  int const N = fine->N;
 
-  uint64_t const N = arguments->N;
+  if (coarse->N * 2 != N) {
+    prolongateInterpolated(coarse, fine);
+    return;
+  }
 
-  arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) *
-                                sizeof(double));
-  arguments->Matrix =
-      allocateMemory(arguments->num_matrices * sizeof(double **));
+#pragma omp for schedule(runtime)
+  for (int i = 1; i < N; i++) {
+    double const *e0 = gridRow(&coarse->u, i / 2);
+    double const *e1 = gridRow(&coarse->u, (i + 1) / 2);
+    double *u = gridRow(&fine->u, i);
 
-  for (i = 0; i < arguments->num_matrices; i++) {
-    arguments->Matrix[i] = allocateMemory((N + 1) * sizeof(double *));
+    for (int j = 1; j < N; j++) {
+      int const J0 = j / 2;
+      int const J1 = (j + 1) / 2;
 
-    for (j = 0; j <= N; j++) {
-      arguments->Matrix[i][j] =
-          arguments->M + (i * (N + 1) * (N + 1)) + (j * (N + 1));
+      u[j] += 0.25 * (e0[J0] + e0[J1] + e1[J0] + e1[J1]);
     }
   }
 }
 
 /* ************************************************************************ */
-/* initMatrices: Initialize matrix/matrices and some global variables       */
+/* cycleMultigrid: one V- or F-cycle on the levels [l, depth)               */
+/*                                                                          */
+/* The coarsest level (N = 2, a single unknown) is solved by N + 1          */
+/* red-black SOR sweeps. An F-cycle follows its recursive F-cycle by a      */
+/* V-cycle.                                                                 */
 /* ************************************************************************ */
-static void initMatrices(struct calculation_arguments *arguments,
-                         struct options const *options) {
-  uint64_t g, i, j; /* local variables for loops */
+static void cycleMultigrid(struct multigrid_level const *levels, int l,
+                           int depth, uint64_t cycle,
+                           struct grid const *residuum,
+                           struct calculation_arguments const *arguments) {
+  struct multigrid_level const *level = &levels[l];
+
+  if (l == depth - 1) {
+    smoothLevel(level, arguments, level->N + 1,
+                2.0 / (1.0 + sin(PI / level->N)));
+    return;
+  }
 
-  uint64_t const N = arguments->N;
-  double const h = arguments->h;
-  double ***Matrix = arguments->Matrix;
+  smoothLevel(level, arguments, MG_PRE_SMOOTHING, 1.0);
+  restrictResidual(level, &levels[l + 1], residuum, arguments);
 
-  /* initialize matrix/matrices with zeros */
-  for (g = 0; g < arguments->num_matrices; g++) {
-    for (i = 0; i <= N; i++) {
-      for (j = 0; j <= N; j++) {
-        Matrix[g][i][j] = 0.0;
+  cycleMultigrid(levels, l + 1, depth, cycle, residuum, arguments);
+
+  if (cycle == MG_CYCLE_F) {
+    cycleMultigrid(levels, l + 1, depth, MG_CYCLE_V, residuum, arguments);
+  }
+
+  prolongate(&levels[l + 1], level);
+  smoothLevel(level, arguments, MG_POST_SMOOTHING, 1.0);
+}
+
+/* ************************************************************************ */
+/* calculateMultigrid: solves the equation with geometric multigrid         */
+/*                                                                          */
+/* N = 8 * (interlines + 1) is halved down to N = 2. While N is even, every */
+/* coarse line is every second line of the finer level. An odd N is rounded */
+/* up to (N + 1) / 2 spaces and the equation is discretized anew on that    */
+/* grid; between such levels the correction is interpolated bilinearly.     */
+/* These levels reduce the error a little less than halving, but the work   */
+/* per cycle stays linear in the number of elements. One iteration is one   */
+/* V- or F-cycle (PARTDIFF_CYCLE) with red-black Gauß-Seidel smoothing,     */
+/* full-weighting restriction and bilinear prolongation. The second matrix  */
+/* holds the residuum of the finer levels. The precision is measured in the */
+/* last smoothing sweep, the same way as for Gauß-Seidel.                   */
+/* ************************************************************************ */
+static void calculateMultigrid(struct calculation_arguments const *arguments,
+                               struct calculation_results *results,
+                               struct options const *options) {
+  struct multigrid_level *levels;
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+  int depth, l;
+
+  int const N = arguments->N;
+  int term_iteration = options->term_iteration;
+
+  struct grid const *residuum = &arguments->Matrix[1];
+
+  /* coarsen down to a single unknown */
+  depth = 1;
+
+  for (int n = N; n > 2; n = (n + 1) / 2) {
+    depth++;
+  }
+
+  levels = allocateMemory(depth * sizeof(*levels));
+
+  levels[0].N = N;
+  levels[0].u = arguments->Matrix[0];
+  levels[0].b.data = NULL;
+  levels[0].size = 0;
+
+  for (l = 1; l < depth; l++) {
+    int const n = (levels[l - 1].N + 1) / 2;
+    uint64_t const stride = paddedStride(n + 1, sizeof(double));
+    uint64_t const pitch = (n + 1) * stride;
+
+    /* mapped memory is zero, so the borders of u stay zero */
+    levels[l].N = n;
+    levels[l].size = 2 * pitch * sizeof(double);
+    levels[l].u.data = allocateGrid(&levels[l].size, options->huge_pages);
+    levels[l].u.stride = stride;
+    levels[l].b.data = levels[l].u.data + pitch;
+    levels[l].b.stride = stride;
+  }
+
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      smoothLevel(&levels[0], arguments, MG_PRE_SMOOTHING, 1.0);
+      restrictResidual(&levels[0], &levels[1], residuum, arguments);
+
+      cycleMultigrid(levels, 1, depth, options->cycle, residuum, arguments);
+
+      if (options->cycle == MG_CYCLE_F) {
+        cycleMultigrid(levels, 1, depth, MG_CYCLE_V, residuum, arguments);
+      }
+
+      prolongate(&levels[1], &levels[0]);
+      smoothLevel(&levels[0], arguments, MG_POST_SMOOTHING - 1, 1.0);
+
+      /* the last sweep also measures the residuum */
+      for (int color = 0; color < 2; color++) {
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+        for (int i = 1; i < N; i++) {
+          double fpisin_i;
+          double const *source = levelSource(&levels[0], arguments, i, &fpisin_i);
+
+          maxResiduum = sweepRedBlackRow(
+              gridRow(&levels[0].u, i), gridRow(&levels[0].u, i - 1),
+              gridRow(&levels[0].u, i + 1), 1 + ((i + 1 + color) & 1), N,
+              fpisin_i, source, 1.0, 1, maxResiduum);
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
       }
     }
   }
 
-  /* initialize borders, depending on function (function 2: nothing to do) */
-  if (options->inf_func == FUNC_F0) {
-    for (g = 0; g < arguments->num_matrices; g++) {
-      for (i = 0; i <= N; i++) {
-        Matrix[g][i][0] = 1.0 - (h * i);
-        Matrix[g][i][N] = h * i;
-        Matrix[g][0][i] = 1.0 - (h * i);
-        Matrix[g][N][i] = h * i;
-      }
+  for (l = 1; l < depth; l++) {
+    munmap(levels[l].u.data, levels[l].size);
+  }
+
+  free(levels);
+
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* symmetricElement: maps element (i, j) of the whole matrix onto the       */
+/* element of the stored sub-domain with the same value                     */
+/*                                                                          */
+/* The sub-domains are 1 <= i <= j <= N/2 for SYMMETRY_FULL and i <= j,     */
+/* i + j <= N for SYMMETRY_DIAGONALS, plus their borders.                   */
+/* ************************************************************************ */
+static void symmetricElement(struct calculation_arguments const *arguments,
+                             uint64_t *i, uint64_t *j) {
+  uint64_t const N = arguments->N;
+  uint64_t tmp;
+
+  if (arguments->symmetry == SYMMETRY_NONE) {
+    return;
+  }
+
+  if (arguments->symmetry == SYMMETRY_FULL) {
+    /* mid-lines */
+    *i = (*i > N - *i) ? N - *i : *i;
+    *j = (*j > N - *j) ? N - *j : *j;
+  }
+
+  /* diagonal */
+  if (*i > *j) {
+    tmp = *i;
+    *i = *j;
+    *j = tmp;
+  }
+
+  /* anti-diagonal */
+  if (arguments->symmetry == SYMMETRY_DIAGONALS && *i + *j > N) {
+    tmp = *i;
+    *i = N - *j;
+    *j = N - tmp;
+  }
+}
+
+/* ************************************************************************ */
+/* symmetricColumns: columns [*j0, *j1] of line i in the sub-domain         */
+/* ************************************************************************ */
+static inline void
+symmetricColumns(struct calculation_arguments const *arguments, int i, int *j0,
+                 int *j1) {
+  int const N = arguments->N;
+
+  *j0 = i;
+  *j1 = (arguments->symmetry == SYMMETRY_FULL) ? N / 2 : N - i;
+}
+
+/* ************************************************************************ */
+/* findGhosts: lists the mirrored elements next to the sub-domain           */
+/*                                                                          */
+/* A ghost is an inner element outside of the sub-domain that a sub-domain  */
+/* element needs as neighbour. ghosts[2k] is its offset in a matrix,        */
+/* ghosts[2k+1] the offset of the element with the same value. With         */
+/* ghosts = NULL, the ghosts are only counted.                              */
+/* ************************************************************************ */
+static uint64_t findGhosts(struct calculation_arguments const *arguments,
+                           char *seen, uint64_t *ghosts) {
+  int const N = arguments->N;
+  uint64_t const stride = arguments->Matrix[0].stride;
+  uint64_t count = 0;
+
+  for (int i = 1; i <= N / 2; i++) {
+    int j0, j1;
+
+    symmetricColumns(arguments, i, &j0, &j1);
+
+    for (int j = j0; j <= j1; j++) {
+      int const a[4] = {i - 1, i + 1, i, i};
+      int const b[4] = {j, j, j - 1, j + 1};
 
-      Matrix[g][N][0] = 0.0;
-      Matrix[g][0][N] = 0.0;
+      for (int k = 0; k < 4; k++) {
+        uint64_t si = a[k], sj = b[k];
+
+        if (a[k] == 0 || a[k] == N || b[k] == 0 || b[k] == N) {
+          continue;
+        }
+
+        symmetricElement(arguments, &si, &sj);
+
+        /* inside the sub-domain or already listed */
+        if ((si == (uint64_t)a[k] && sj == (uint64_t)b[k]) ||
+            seen[a[k] * stride + b[k]]) {
+          continue;
+        }
+
+        seen[a[k] * stride + b[k]] = 1;
+
+        if (ghosts != NULL) {
+          ghosts[2 * count] = a[k] * stride + b[k];
+          ghosts[2 * count + 1] = si * stride + sj;
+        }
+
+        count++;
+      }
     }
   }
+
+  return count;
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* calculateSymmetric: solves the equation with the Jacobi or the           */
+/* (over-relaxed) red-black method on the sub-domain of detectSymmetry()    */
+/*                                                                          */
+/* Only the sub-domain is computed; after every sweep, respectively every   */
+/* color, its ghosts are copied from the elements they mirror. That is an   */
+/* eighth (FUNC_FPISIN) or a quarter (FUNC_F0) of the work per iteration,   */
+/* and a quarter or half of the memory. displayMatrix() reads the other     */
+/* elements through symmetricElement(). The results equal those of the      */
+/* whole matrix up to rounding.                                             */
 /* ************************************************************************ */
-static void calculate(struct calculation_arguments const *arguments,
-                      struct calculation_results *results,
-                      struct options const *options) {
-  int i, j;           /* local variables for loops */
-  int m1, m2;         /* used as indices for old and new matrices */
-  double star;        /* four times center value minus 4 neigh.b values */
-  double residuum;    /* residuum of current iteration */
+static void calculateSymmetric(struct calculation_arguments const *arguments,
+                               struct calculation_results *results,
+                               struct options const *options) {
+  int m1 = 0, m2 = 0; /* used as indices for old and new matrices */
   double maxResiduum; /* maximum residuum value of a slave in iteration */
 
   int const N = arguments->N;
-  double const h = arguments->h;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
 
-  double pih = 0.0;
-  double fpisin = 0.0;
+  double const omega = relaxationFactor(options);
+  int const jacobi = (options->method == METH_JACOBI);
+
+  size_t const elements = arguments->rows * arguments->Matrix[0].stride;
+  char *seen = allocateMemory(elements);
+  uint64_t *ghosts;
+  uint64_t num_ghosts;
 
   int term_iteration = options->term_iteration;
 
-  /* initialize m1 and m2 depending on algorithm */
-  if (options->method == METH_JACOBI) {
-    m1 = 0;
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(arguments->sin_col != NULL, 0),
+      selectJacobiRowKernel(arguments->sin_col != NULL, 1)};
+
+  memset(seen, 0, elements);
+  num_ghosts = findGhosts(arguments, seen, NULL);
+  ghosts = allocateMemory(2 * num_ghosts * sizeof(uint64_t));
+
+  memset(seen, 0, elements);
+  findGhosts(arguments, seen, ghosts);
+  free(seen);
+
+  if (jacobi) {
     m2 = 1;
-  } else {
-    m1 = 0;
-    m2 = 0;
   }
 
-  if (options->inf_func == FUNC_FPISIN) {
-    pih = PI * h;
-    fpisin = 0.25 * TWO_PI_SQUARE * h * h;
+  maxResiduum = 0;
+
+#pragma omp parallel
+  {
+    while (term_iteration > 0) {
+      int const check =
+          checkResiduum(options, results->stat_iteration + 1, term_iteration);
+
+      /* Jacobi: one sweep, red-black: one sweep per color */
+      for (int color = 0; color < (jacobi ? 1 : 2); color++) {
+        struct grid const *Matrix_Out = &arguments->Matrix[m1];
+        struct grid const *Matrix_In = &arguments->Matrix[m2];
+
+#pragma omp for schedule(runtime) reduction(max : maxResiduum)
+        for (int i = 1; i <= N / 2; i++) {
+          double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+          int j0, j1;
+
+          symmetricColumns(arguments, i, &j0, &j1);
+
+          if (jacobi) {
+            /* the kernel computes the columns [1, n), so shift by j0 - 1 */
+            int const o = j0 - 1;
+
+            maxResiduum = jacobiRow[check](
+                gridRow(Matrix_Out, i) + o, gridRow(Matrix_In, i - 1) + o,
+                gridRow(Matrix_In, i) + o, gridRow(Matrix_In, i + 1) + o,
+                (sin_col != NULL) ? sin_col + o : NULL, fpisin_i, j1 - o + 1,
+                maxResiduum);
+          } else {
+            maxResiduum = sweepRedBlackRow(
+                gridRow(Matrix_Out, i), gridRow(Matrix_Out, i - 1),
+                gridRow(Matrix_Out, i + 1), j0 + ((i + j0 + color) & 1), j1 + 1,
+                fpisin_i, sin_col, omega, check, maxResiduum);
+          }
+        }
+
+        /* mirror the new values */
+#pragma omp for schedule(static)
+        for (uint64_t k = 0; k < num_ghosts; k++) {
+          Matrix_Out->data[ghosts[2 * k]] = Matrix_Out->data[ghosts[2 * k + 1]];
+        }
+      }
+
+#pragma omp single
+      {
+        int tmp;
+
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        /* exchange m1 and m2 */
+        tmp = m1;
+        m1 = m2;
+        m2 = tmp;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (check && maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
+      }
+    }
   }
 
-  while (term_iteration > 0) {
-    double **Matrix_Out = arguments->Matrix[m1];
-    double **Matrix_In = arguments->Matrix[m2];
+  free(ghosts);
 
-    maxResiduum = 0;
+  results->m = m2;
+}
 
-    /* over all rows */
-    for (i = 1; i < N; i++) {
-      double fpisin_i = 0.0;
+/* ************************************************************************ */
+/* clearBorder: sets the border of a work matrix to zero                    */
+/* ************************************************************************ */
+static void clearBorder(struct grid const *grid, int N) {
+  for (int i = 0; i <= N; i++) {
+    gridRow(grid, i)[0] = 0.0;
+    gridRow(grid, i)[N] = 0.0;
+    gridRow(grid, 0)[i] = 0.0;
+    gridRow(grid, N)[i] = 0.0;
+  }
+}
 
-      if (options->inf_func == FUNC_FPISIN) {
-        fpisin_i = fpisin * sin(pih * (double)i);
-      }
+/* ************************************************************************ */
+/* laplaceRowDot: returns the sum of p[j] * (A p)[j] over one row, A being  */
+/* the 5-point Laplacian times h^2                                          */
+/* ************************************************************************ */
+static inline double laplaceRowDot(double const *restrict above,
+                                   double const *restrict row,
+                                   double const *restrict below, int N) {
+  double dot = 0.0;
 
-      /* over all columns */
-      for (j = 1; j < N; j++) {
-        star = 0.25 * (Matrix_In[i - 1][j] + Matrix_In[i][j - 1] +
-                       Matrix_In[i][j + 1] + Matrix_In[i + 1][j]);
+  for (int j = 1; j < N; j++) {
+    double const Ap =
+        4.0 * row[j] - (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+    dot += row[j] * Ap;
+  }
+
+  return dot;
+}
+
+/* ************************************************************************ */
+/* updateResiduumRow: u += alpha * p and r -= alpha * A p for one row       */
+/*                                                                          */
+/* The new residuum is preconditioned by z = scale * r. Without a z row,    */
+/* r * z is accumulated into *rz; with one, z is stored for the symmetric   */
+/* Gauß-Seidel passes, which compute r * z themselves. Returns the maximum  */
+/* of maxResiduum and |r| / 4, the correction Jacobi would make.            */
+/* ************************************************************************ */
+static inline double
+updateResiduumRow(double *restrict u, double *restrict r, double *restrict z,
+                  double const *restrict above, double const *restrict row,
+                  double const *restrict below, double alpha, double scale,
+                  int N, double *rz, double maxResiduum) {
+  for (int j = 1; j < N; j++) {
+    double const Ap =
+        4.0 * row[j] - (above[j] + row[j - 1] + row[j + 1] + below[j]);
+    double residuum;
+
+    u[j] += alpha * row[j];
+    r[j] -= alpha * Ap;
+
+    if (z != NULL) {
+      z[j] = scale * r[j];
+    } else {
+      *rz += r[j] * (scale * r[j]);
+    }
+
+    residuum = 0.25 * ((r[j] < 0) ? -r[j] : r[j]);
+    maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+  }
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* preconditionRow: one color of a red-black Gauß-Seidel pass solving       */
+/* A z = r, returns the sum of r[j] * z[j] over the updated elements        */
+/* ************************************************************************ */
+static inline double preconditionRow(double *restrict z,
+                                     double const *restrict above,
+                                     double const *restrict below,
+                                     double const *restrict r, int first,
+                                     int N) {
+  double rz = 0.0;
+
+  for (int j = first; j < N; j += 2) {
+    z[j] = 0.25 * (r[j] + above[j] + z[j - 1] + z[j + 1] + below[j]);
+    rz += r[j] * z[j];
+  }
+
+  return rz;
+}
+
+/* ************************************************************************ */
+/* calculateConjugateGradient: solves the equation with the preconditioned  */
+/* conjugate gradient method                                                */
+/*                                                                          */
+/* A is never assembled, A p is computed from the 5-point stencil whenever  */
+/* it is needed, so only the residuum r and the direction p (and z for the  */
+/* symmetric Gauß-Seidel preconditioner) need memory. The preconditioner    */
+/* (PARTDIFF_PRECOND) is one symmetric red-black Gauß-Seidel sweep from     */
+/* z = 0: red, black, red again, which about halves the iterations. Jacobi  */
+/* (z = r / 4) is kept for comparison only: the diagonal of A is 4          */
+/* everywhere, so it only scales r and yields the iterates of plain CG.     */
+/* Dot products and vector updates are fused into three to five parallel    */
+/* loops per iteration. The precision is max |r| / 4, the correction        */
+/* Jacobi would make, so TERM_PREC means the same as for the other methods. */
+/* ************************************************************************ */
+static void
+calculateConjugateGradient(struct calculation_arguments const *arguments,
+                           struct calculation_results *results,
+                           struct options const *options) {
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+  double rz, rz_new;  /* r * z of the last and the current iteration */
+  double pq;          /* p * A p */
+
+  int const N = arguments->N;
+  int term_iteration = options->term_iteration;
+
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+
+  struct grid const *u = &arguments->Matrix[0];
+  struct grid const *r = &arguments->Matrix[1];
+  struct grid const *p = &arguments->Matrix[2];
+  struct grid const *z =
+      (options->precond == PRECOND_SGS) ? &arguments->Matrix[3] : NULL;
+
+  /* z (or the scaled r) is the preconditioned residuum */
+  double const scale = (options->precond == PRECOND_NONE) ? 1.0 : 0.25;
+
+  clearBorder(p, N);
+
+  if (z != NULL) {
+    clearBorder(z, N);
+  }
+
+  maxResiduum = 0;
+  rz = 0;
+  rz_new = 0;
+  pq = 0;
+
+#pragma omp parallel
+  {
+    /* r = b - A u, with the borders of u as boundary condition */
+#pragma omp for schedule(runtime) reduction(+ : rz)
+    for (int i = 1; i < N; i++) {
+      double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+      double const *above = gridRow(u, i - 1);
+      double const *row = gridRow(u, i);
+      double const *below = gridRow(u, i + 1);
+      double *rrow = gridRow(r, i);
+
+      for (int j = 1; j < N; j++) {
+        double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+        if (sin_col != NULL) {
+          star += fpisin_i * sin_col[j];
+        }
+
+        rrow[j] = 4.0 * (star - row[j]);
 
-        if (options->inf_func == FUNC_FPISIN) {
-          star += fpisin_i * sin(pih * (double)j);
+        if (z != NULL) {
+          gridRow(z, i)[j] = scale * rrow[j];
+        } else {
+          rz += rrow[j] * (scale * rrow[j]);
         }
+      }
+    }
 
-        if (options->termination == TERM_PREC || term_iteration == 1) {
-          residuum = Matrix_In[i][j] - star;
-          residuum = (residuum < 0) ? -residuum : residuum;
-          maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+    if (z != NULL) {
+      for (int color = 1; color >= 0; color--) {
+#pragma omp for schedule(runtime) reduction(+ : rz)
+        for (int i = 1; i < N; i++) {
+          rz += preconditionRow(gridRow(z, i), gridRow(z, i - 1),
+                                gridRow(z, i + 1), gridRow(r, i),
+                                1 + ((i + 1 + color) & 1), N);
         }
+      }
+    }
 
-        Matrix_Out[i][j] = star;
+    /* p = z */
+#pragma omp for schedule(runtime)
+    for (int i = 1; i < N; i++) {
+      double const *s = gridRow((z != NULL) ? z : r, i);
+      double const f = (z != NULL) ? 1.0 : scale;
+      double *prow = gridRow(p, i);
+
+      for (int j = 1; j < N; j++) {
+        prow[j] = f * s[j];
       }
     }
 
-    results->stat_iteration++;
-    results->stat_precision = maxResiduum;
+    while (term_iteration > 0) {
+      double alpha, beta;
 
-    /* exchange m1 and m2 */
-    i = m1;
-    m1 = m2;
-    m2 = i;
+#pragma omp for schedule(runtime) reduction(+ : pq)
+      for (int i = 1; i < N; i++) {
+        pq += laplaceRowDot(gridRow(p, i - 1), gridRow(p, i),
+                            gridRow(p, i + 1), N);
+      }
 
-    /* check for stopping calculation depending on termination method */
-    if (options->termination == TERM_PREC) {
-      if (maxResiduum < options->term_precision) {
-        term_iteration = 0;
+      alpha = (pq > 0) ? rz / pq : 0.0;
+
+#pragma omp for schedule(runtime) reduction(+ : rz_new)                      \
+    reduction(max : maxResiduum)
+      for (int i = 1; i < N; i++) {
+        maxResiduum = updateResiduumRow(
+            gridRow(u, i), gridRow(r, i), (z != NULL) ? gridRow(z, i) : NULL,
+            gridRow(p, i - 1), gridRow(p, i), gridRow(p, i + 1), alpha, scale,
+            N, &rz_new, maxResiduum);
+      }
+
+      /* z = r / 4 holds on red, now black and red again */
+      if (z != NULL) {
+        for (int color = 1; color >= 0; color--) {
+#pragma omp for schedule(runtime) reduction(+ : rz_new)
+          for (int i = 1; i < N; i++) {
+            rz_new += preconditionRow(gridRow(z, i), gridRow(z, i - 1),
+                                      gridRow(z, i + 1), gridRow(r, i),
+                                      1 + ((i + 1 + color) & 1), N);
+          }
+        }
+      }
+
+      beta = (rz > 0) ? rz_new / rz : 0.0;
+
+      /* p = z + beta * p */
+#pragma omp for schedule(runtime)
+      for (int i = 1; i < N; i++) {
+        double const *s = gridRow((z != NULL) ? z : r, i);
+        double const f = (z != NULL) ? 1.0 : scale;
+        double *prow = gridRow(p, i);
+
+        for (int j = 1; j < N; j++) {
+          prow[j] = f * s[j] + beta * prow[j];
+        }
+      }
+
+#pragma omp single
+      {
+        results->stat_iteration++;
+        results->stat_precision = maxResiduum;
+
+        rz = rz_new;
+        rz_new = 0;
+        pq = 0;
+
+        /* check for stopping calculation depending on termination method */
+        if (options->termination == TERM_PREC) {
+          if (maxResiduum < options->term_precision) {
+            term_iteration = 0;
+          }
+        } else if (options->termination == TERM_ITER) {
+          term_iteration--;
+        }
+
+        maxResiduum = 0;
       }
-    } else if (options->termination == TERM_ITER) {
-      term_iteration--;
     }
   }
 
-  results->m = m2;
+  results->m = 0;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void calculate(struct calculation_arguments const *arguments,
+                      struct calculation_results *results,
+                      struct options const *options) {
+#ifdef _OPENMP
+  omp_set_num_threads(options->number);
+
+  /* libgomp defaults to dynamic,1 for schedule(runtime) */
+  if (getenv("OMP_SCHEDULE") == NULL) {
+    omp_set_schedule(omp_sched_static, 0);
+  }
+#endif
+
+  if (arguments->symmetry != SYMMETRY_NONE) {
+    calculateSymmetric(arguments, results, options);
+  } else if (options->method == METH_JACOBI &&
+             options->precision == PRECISION_MIXED) {
+    calculateJacobiMixed(arguments, results, options);
+  } else if (options->method == METH_JACOBI && options->inplace) {
+    calculateJacobiInPlace(arguments, results, options);
+  } else if (options->method == METH_JACOBI &&
+             options->termination == TERM_ITER && options->time_depth > 1) {
+    calculateJacobiTimeBlocked(arguments, results, options);
+  } else if (options->method == METH_JACOBI) {
+    calculateJacobi(arguments, results, options);
+  } else if (options->method == METH_CHEBYSHEV) {
+    calculateChebyshev(arguments, results, options);
+  } else if (options->method == METH_RED_BLACK ||
+             options->method == METH_SOR_RED_BLACK) {
+    calculateRedBlack(arguments, results, options);
+  } else if (options->method == METH_MULTIGRID) {
+    calculateMultigrid(arguments, results, options);
+  } else if (options->method == METH_CG) {
+    calculateConjugateGradient(arguments, results, options);
+  } else if (options->async) {
+    calculateAsync(arguments, results, options);
+  } else if (options->number > 1) {
+    calculateGaussSeidelWavefront(arguments, results, options);
+  } else {
+    calculateGaussSeidel(arguments, results, options);
+  }
 }
 
 /* ************************************************************************ */
@@ -248,20 +2646,39 @@ static void calculate(struct calculation_arguments const *arguments,
 static void displayStatistics(struct calculation_arguments const *arguments,
                               struct calculation_results const *results,
                               struct options const *options) {
-  int N = arguments->N;
   double time = (comp_time.tv_sec - start_time.tv_sec) +
                 (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
   printf("Berechnungszeit:    %f s \n", time);
-  printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) *
-                                             arguments->num_matrices / 1024.0 /
-                                             1024.0);
+  printf("Speicherbedarf:     %f MiB\n", arguments->M_size / 1024.0 / 1024.0);
   printf("Berechnungsmethode: ");
 
   if (options->method == METH_GAUSS_SEIDEL) {
     printf("Gauß-Seidel");
   } else if (options->method == METH_JACOBI) {
     printf("Jacobi");
+
+    if (options->precision == PRECISION_MIXED) {
+      printf(" (float/double)");
+    }
+  } else if (options->method == METH_RED_BLACK) {
+    printf("Gauß-Seidel (rot-schwarz)");
+  } else if (options->method == METH_SOR) {
+    printf("SOR (omega = %f)", options->omega);
+  } else if (options->method == METH_SOR_RED_BLACK) {
+    printf("SOR (rot-schwarz, omega = %f)", options->omega);
+  } else if (options->method == METH_MULTIGRID) {
+    printf("Mehrgitter (%s-Zyklus)", (options->cycle == MG_CYCLE_F) ? "F" : "V");
+  } else if (options->method == METH_CG) {
+    printf("CG");
+
+    if (options->precond == PRECOND_JACOBI) {
+      printf(" (Jacobi-Vorkonditionierung)");
+    } else if (options->precond == PRECOND_SGS) {
+      printf(" (SGS-Vorkonditionierung)");
+    }
+  } else if (options->method == METH_CHEBYSHEV) {
+    printf("Jacobi (Tschebyscheff-beschleunigt)");
   }
 
   printf("\n");
@@ -304,7 +2721,7 @@ static void displayMatrix(struct calculation_arguments *arguments,
                           struct options *options) {
   int x, y;
 
-  double **Matrix = arguments->Matrix[results->m];
+  struct grid const *Matrix = &arguments->Matrix[results->m];
 
   int const interlines = options->interlines;
 
@@ -312,7 +2729,13 @@ static void displayMatrix(struct calculation_arguments *arguments,
 
   for (y = 0; y < 9; y++) {
     for (x = 0; x < 9; x++) {
-      printf("%11.8f", Matrix[y * (interlines + 1)][x * (interlines + 1)]);
+      uint64_t i = y * (interlines + 1);
+      uint64_t j = x * (interlines + 1);
+
+      /* the element mirrored into the stored sub-domain, if any */
+      symmetricElement(arguments, &i, &j);
+
+      printf("%11.8f", gridRow(Matrix, i)[j]);
     }
 
     printf("\n");
@@ -333,8 +2756,9 @@ int main(int argc, char **argv) {
 
   initVariables(&arguments, &results, &options);
 
-  allocateMatrices(&arguments);
+  allocateMatrices(&arguments, &options);
   initMatrices(&arguments, &options);
+  initSourceTerm(&arguments, &options);
 
   gettimeofday(&start_time, NULL);
   calculate(&arguments, &results, &options);
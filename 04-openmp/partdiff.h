@@ -29,10 +29,39 @@
 #define MAX_THREADS 1024
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI 2
+#define METH_RED_BLACK 3
+#define METH_SOR 4
+#define METH_SOR_RED_BLACK 5
+#define METH_MULTIGRID 6
+#define METH_CG 7
+#define METH_CHEBYSHEV 8
 #define FUNC_F0 1
 #define FUNC_FPISIN 2
 #define TERM_PREC 1
 #define TERM_ITER 2
+#define DEFAULT_TILE_SIZE 64
+#define MAX_TILE_SIZE (MAX_INTERLINES * 8 + 8)
+#define MAX_TIME_DEPTH 1024
+#define MG_CYCLE_V 1
+#define MG_CYCLE_F 2
+#define MG_PRE_SMOOTHING 2
+#define MG_POST_SMOOTHING 2
+#define PRECOND_NONE 0
+#define PRECOND_JACOBI 1
+#define PRECOND_SGS 2
+#define PRECISION_DOUBLE 1
+#define PRECISION_MIXED 2
+#define MIXED_SWEEPS 32
+#define CHECK_SYNC 0
+#define CHECK_ASYNC 1
+#define SYMMETRY_NONE 0
+#define SYMMETRY_DIAGONALS 1 /* FUNC_F0 */
+#define SYMMETRY_FULL 2      /* FUNC_FPISIN */
+#define CACHE_LINE 64
+#define HUGE_PAGES_OFF 0
+#define HUGE_PAGES_TRANSPARENT 1
+#define HUGE_PAGES_EXPLICIT 2
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 struct options {
   uint64_t number;         /* Number of threads                              */
@@ -42,13 +71,43 @@ struct options {
   uint64_t termination;    /* termination condition                          */
   uint64_t term_iteration; /* terminate if iteration number reached          */
   double term_precision;   /* terminate if precision reached                 */
+  uint64_t tile_size;      /* edge length of a tile (PARTDIFF_TILE)          */
+  uint64_t time_depth;     /* iterations per tile (PARTDIFF_TIME_DEPTH)      */
+  uint64_t huge_pages;     /* huge pages for matrices (PARTDIFF_HUGEPAGES)   */
+  double omega;            /* relaxation factor of SOR (PARTDIFF_OMEGA)      */
+  uint64_t cycle;          /* multigrid cycle, V or F (PARTDIFF_CYCLE)       */
+  uint64_t precond;        /* CG preconditioner (PARTDIFF_PRECOND)           */
+  uint64_t precision;      /* Jacobi in double or float (PARTDIFF_PRECISION) */
+  uint64_t check_interval; /* iterations per residuum check (TERM_PREC)      */
+  uint64_t check_async;    /* Jacobi residuum checked by a helper thread     */
+  uint64_t inplace;        /* Jacobi on one matrix (PARTDIFF_INPLACE)        */
+  uint64_t symmetry;       /* solve a sub-domain only (PARTDIFF_SYMMETRY)    */
+  uint64_t async;          /* barrier-free Gauß-Seidel (PARTDIFF_ASYNC)      */
 };
 
+/* Kernel computing one row of the Jacobi method, see stencil.c */
+typedef double (*jacobi_row_kernel)(double *restrict, double const *restrict,
+                                    double const *restrict,
+                                    double const *restrict,
+                                    double const *restrict, double, int,
+                                    double);
+
+/* Kernel computing one row of the float sweeps, see stencil.c */
+typedef void (*jacobi_row_kernel_float)(float *restrict, float const *restrict,
+                                        float const *restrict,
+                                        float const *restrict,
+                                        float const *restrict, int);
+
 /* *************************** */
 /* Some function declarations. */
 /* *************************** */
 /* Documentation in files      */
 /* - askparams.c               */
 /* - displaymatrix.c           */
+/* - stencil.c                 */
 /* *************************** */
 void askParams(struct options *, int, char **);
+
+jacobi_row_kernel selectJacobiRowKernel(int, int);
+
+jacobi_row_kernel_float selectJacobiRowKernelFloat(void);
@@ -40,8 +40,11 @@
 /****************************************************************************/
 /** int *method;                                                           **/
 /**         Bezeichnet das bei der L"osung der Poissongleichung zu         **/
-/**         verwendende Verfahren (Gauß-Seidel oder Jacobi).               **/
-/** Werte:  METH_GAUSS_SEIDEL  oder METH_JACOBI (definierte Konstanten)    **/
+/**         verwendende Verfahren (Gauß-Seidel, Jacobi, Gauß-Seidel        **/
+/**         in Rot-Schwarz-Reihenfolge oder SOR in beiden Reihenfolgen).   **/
+/** Werte:  METH_GAUSS_SEIDEL, METH_JACOBI, METH_RED_BLACK, METH_SOR oder  **/
+/**         METH_SOR_RED_BLACK                                             **/
+/**         (definierte Konstanten)                                        **/
 /****************************************************************************/
 /** int *interlines:                                                       **/
 /**         Gibt die Zwischenzeilen zwischen den auszugebenden             **/
@@ -86,9 +89,12 @@ static void usage(char *name) {
   printf("Usage: %s [num] [method] [lines] [func] [term] [prec/iter]\n", name);
   printf("\n");
   printf("  - num:       number of threads (1 .. %d)\n", MAX_THREADS);
-  printf("  - method:    calculation method (1 .. 2)\n");
+  printf("  - method:    calculation method (1 .. 5)\n");
   printf("                 %1d: Gauß-Seidel\n", METH_GAUSS_SEIDEL);
   printf("                 %1d: Jacobi\n", METH_JACOBI);
+  printf("                 %1d: Gauß-Seidel (red-black)\n", METH_RED_BLACK);
+  printf("                 %1d: SOR\n", METH_SOR);
+  printf("                 %1d: SOR (red-black)\n", METH_SOR_RED_BLACK);
   printf("  - lines:     number of interlines (0 .. %d)\n", MAX_INTERLINES);
   printf("                 matrixsize = (interlines * 8) + 9\n");
   printf("  - func:      interference function (1 .. 2)\n");
@@ -103,6 +109,19 @@ static void usage(char *name) {
   printf("                 precision:  1e-4 .. 1e-20\n");
   printf("                 iterations:    0 .. %d\n", MAX_ITERATION);
   printf("\n");
+  printf("Environment:\n");
+  printf("  - PARTDIFF_HUGEPAGES: huge pages for the matrices\n");
+  printf("                 %1d: off\n", HUGE_PAGES_OFF);
+  printf("                 %1d: transparent huge pages (default)\n",
+         HUGE_PAGES_TRANSPARENT);
+  printf("                 %1d: reserved huge pages (MAP_HUGETLB)\n",
+         HUGE_PAGES_EXPLICIT);
+  printf("  - PARTDIFF_OMEGA: relaxation factor of SOR (0 .. 2, default:\n");
+  printf("                 2 / (1 + sin(pi * h)), optimal for f(x,y) = 0)\n");
+  printf("  - PARTDIFF_ASYNC: 1: Gauß-Seidel and SOR without barriers, every\n");
+  printf("                    thread sweeps its rows with the values of its\n");
+  printf("                    neighbours as they are (default 0)\n");
+  printf("\n");
   printf("Example: %s 1 2 100 1 2 100 \n", name);
 }
 
@@ -112,7 +131,8 @@ static int check_number(struct options *options) {
 
 static int check_method(struct options *options) {
   return (options->method == METH_GAUSS_SEIDEL ||
-          options->method == METH_JACOBI);
+          options->method == METH_JACOBI || options->method == METH_RED_BLACK ||
+          options->method == METH_SOR || options->method == METH_SOR_RED_BLACK);
 }
 
 static int check_interlines(struct options *options) {
@@ -136,6 +156,60 @@ static int check_term_iteration(struct options *options) {
   return (options->term_iteration <= MAX_ITERATION);
 }
 
+static int check_huge_pages(struct options *options) {
+  return (options->huge_pages == HUGE_PAGES_OFF ||
+          options->huge_pages == HUGE_PAGES_TRANSPARENT ||
+          options->huge_pages == HUGE_PAGES_EXPLICIT);
+}
+
+static int check_omega(struct options *options) {
+  return (options->omega > 0 && options->omega < 2);
+}
+
+static int check_async(struct options *options) {
+  return (options->async == 0 || options->async == 1);
+}
+
+/* reads the tuning parameters that are not part of the command line */
+static void askEnvironment(struct options *options, char *name) {
+  char const *env;
+  int ret;
+
+  options->huge_pages = HUGE_PAGES_TRANSPARENT;
+
+  if ((env = getenv("PARTDIFF_HUGEPAGES")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->huge_pages));
+
+    if (ret != 1 || !check_huge_pages(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  /* optimal for the model problem: omega = 2 / (1 + sin(pi * h)) */
+  options->omega = 2.0 / (1.0 + sin(PI / (options->interlines * 8 + 8)));
+
+  if ((env = getenv("PARTDIFF_OMEGA")) != NULL) {
+    ret = sscanf(env, "%lf", &(options->omega));
+
+    if (ret != 1 || !check_omega(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+
+  options->async = 0;
+
+  if ((env = getenv("PARTDIFF_ASYNC")) != NULL) {
+    ret = sscanf(env, "%" SCNu64, &(options->async));
+
+    if (ret != 1 || !check_async(options)) {
+      usage(name);
+      exit(1);
+    }
+  }
+}
+
 void askParams(struct options *options, int argc, char **argv) {
   int ret;
 
@@ -167,6 +241,9 @@ void askParams(struct options *options, int argc, char **argv) {
       printf("Select calculation method:\n");
       printf("  %1d: Gauß-Seidel.\n", METH_GAUSS_SEIDEL);
       printf("  %1d: Jacobi.\n", METH_JACOBI);
+      printf("  %1d: Gauß-Seidel (red-black).\n", METH_RED_BLACK);
+      printf("  %1d: SOR.\n", METH_SOR);
+      printf("  %1d: SOR (red-black).\n", METH_SOR_RED_BLACK);
       printf("method> ");
       fflush(stdout);
       ret = scanf("%" SCNu64, &(options->method));
@@ -294,4 +371,6 @@ void askParams(struct options *options, int argc, char **argv) {
       }
     }
   }
+
+  askEnvironment(options, argv[0]);
 }
@@ -8,8 +8,8 @@
 /**                                                                        **/
 /** File:      partdiff.c                                                  **/
 /**                                                                        **/
-/** Purpose:   Partial differential equation solver for Gauß-Seidel and    **/
-/**            Jacobi method.                                              **/
+/** Purpose:   Partial differential equation solver for Gauß-Seidel,       **/
+/**            red-black Gauß-Seidel, SOR and Jacobi method.               **/
 /**                                                                        **/
 /****************************************************************************/
 /****************************************************************************/
@@ -18,23 +18,46 @@
 /* Include standard header file.                                            */
 /* ************************************************************************ */
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, madvise() */
 
 #include <inttypes.h>
 #include <malloc.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 
 #include "partdiff.h"
 
+/* ************************************************************************ */
+/* A matrix is stored row by row in one flat block of memory. Rows are      */
+/* padded to an odd number of cache lines: every row starts SIMD-aligned    */
+/* and neighbouring rows never map to the same cache sets.                  */
+/* ************************************************************************ */
+struct grid {
+  double *data;    /* element (i, j) is data[i * stride + j]              */
+  uint64_t stride; /* distance between two rows in doubles                */
+};
+
+static inline double *gridRow(struct grid const *grid, uint64_t i) {
+  return grid->data + i * grid->stride;
+}
+
 struct calculation_arguments {
   uint64_t N;            /* number of spaces between lines (lines=N+1)     */
   uint64_t num_matrices; /* number of matrices                             */
   double h;              /* length of a space between two lines            */
-  double ***Matrix;      /* index matrix used for addressing M             */
-  double *M;             /* two matrices with real values                  */
+  struct grid *Matrix;   /* the matrices, pointing into M                  */
+  double *M;             /* memory of all matrices                         */
+  size_t M_size;         /* bytes mapped for M                             */
+  double *fpisin_row;    /* fpisin * sin(pi*h*i) per row (FUNC_FPISIN)     */
+  double *sin_col;       /* sin(pi*h*j) per column (FUNC_FPISIN)           */
 };
 
 struct calculation_results {
@@ -60,6 +83,8 @@ static void initVariables(struct calculation_arguments *arguments,
   arguments->N = (options->interlines * 8) + 9 - 1;
   arguments->num_matrices = (options->method == METH_JACOBI) ? 2 : 1;
   arguments->h = 1.0 / arguments->N;
+  arguments->fpisin_row = NULL;
+  arguments->sin_col = NULL;
 
   results->m = 0;
   results->stat_iteration = 0;
@@ -67,17 +92,24 @@ static void initVariables(struct calculation_arguments *arguments,
 }
 
 /* ************************************************************************ */
-/* freeMatrices: frees memory for matrices                                  */
+/* relaxationFactor: omega of the SOR methods, 1 for all other methods      */
 /* ************************************************************************ */
-static void freeMatrices(struct calculation_arguments *arguments) {
-  uint64_t i;
-
-  for (i = 0; i < arguments->num_matrices; i++) {
-    free(arguments->Matrix[i]);
+static double relaxationFactor(struct options const *options) {
+  if (options->method == METH_SOR || options->method == METH_SOR_RED_BLACK) {
+    return options->omega;
   }
 
+  return 1.0;
+}
+
+/* ************************************************************************ */
+/* freeMatrices: frees memory for matrices                                  */
+/* ************************************************************************ */
+static void freeMatrices(struct calculation_arguments *arguments) {
   free(arguments->Matrix);
-  free(arguments->M);
+  munmap(arguments->M, arguments->M_size);
+  free(arguments->fpisin_row);
+  free(arguments->sin_col);
 }
 
 /* ************************************************************************ */
@@ -95,26 +127,83 @@ static void *allocateMemory(size_t size) {
   return p;
 }
 
+/* ************************************************************************ */
+/* paddedStride: row length in doubles for a matrix with the given number   */
+/* of lines, rounded up to an odd number of cache lines                     */
+/* ************************************************************************ */
+static uint64_t paddedStride(uint64_t lines) {
+  uint64_t const per_line = CACHE_LINE / sizeof(double);
+  uint64_t cache_lines = (lines + per_line - 1) / per_line;
+
+  if (cache_lines % 2 == 0) {
+    cache_lines++;
+  }
+
+  return cache_lines * per_line;
+}
+
+/* ************************************************************************ */
+/* allocateGrid ()                                                          */
+/* maps page-aligned memory for matrices, backed by huge pages if wanted;   */
+/* *size is rounded up to the size actually mapped                          */
+/* ************************************************************************ */
+static void *allocateGrid(size_t *size, uint64_t huge_pages) {
+  void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if (huge_pages == HUGE_PAGES_EXPLICIT) {
+    size_t const rounded = (*size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                           HUGE_PAGE_SIZE;
+
+    p = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (p != MAP_FAILED) {
+      *size = rounded;
+      return p;
+    }
+  }
+#endif
+
+  p = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+           -1, 0);
+
+  if (p == MAP_FAILED) {
+    printf("Speicherprobleme! (%" PRIu64 " Bytes angefordert)\n", *size);
+    exit(1);
+  }
+
+#ifdef MADV_HUGEPAGE
+  if (huge_pages != HUGE_PAGES_OFF) {
+    /* only a hint, the matrices work without transparent huge pages */
+    (void)madvise(p, *size, MADV_HUGEPAGE);
+  }
+#endif
+
+  return p;
+}
+
 /* ************************************************************************ */
 /* allocateMatrices: allocates memory for matrices                          */
 /* ************************************************************************ */
-static void allocateMatrices(struct calculation_arguments *arguments) {
-  uint64_t i, j;
+static void allocateMatrices(struct calculation_arguments *arguments,
+                             struct options const *options) {
+  uint64_t i;
 
   uint64_t const N = arguments->N;
+  uint64_t const stride = paddedStride(N + 1);
+
+  /* one extra cache line keeps row i of two matrices in different sets */
+  uint64_t const pitch = (N + 1) * stride + CACHE_LINE / sizeof(double);
 
-  arguments->M = allocateMemory(arguments->num_matrices * (N + 1) * (N + 1) *
-                                sizeof(double));
+  arguments->M_size = arguments->num_matrices * pitch * sizeof(double);
+  arguments->M = allocateGrid(&arguments->M_size, options->huge_pages);
   arguments->Matrix =
-      allocateMemory(arguments->num_matrices * sizeof(double **));
+      allocateMemory(arguments->num_matrices * sizeof(struct grid));
 
   for (i = 0; i < arguments->num_matrices; i++) {
-    arguments->Matrix[i] = allocateMemory((N + 1) * sizeof(double *));
-
-    for (j = 0; j <= N; j++) {
-      arguments->Matrix[i][j] =
-          arguments->M + (i * (N + 1) * (N + 1)) + (j * (N + 1));
-    }
+    arguments->Matrix[i].data = arguments->M + i * pitch;
+    arguments->Matrix[i].stride = stride;
   }
 }
 
@@ -127,13 +216,13 @@ static void initMatrices(struct calculation_arguments *arguments,
 
   uint64_t const N = arguments->N;
   double const h = arguments->h;
-  double ***Matrix = arguments->Matrix;
+  struct grid const *Matrix = arguments->Matrix;
 
   /* initialize matrix/matrices with zeros */
   for (g = 0; g < arguments->num_matrices; g++) {
     for (i = 0; i <= N; i++) {
       for (j = 0; j <= N; j++) {
-        Matrix[g][i][j] = 0.0;
+        gridRow(&Matrix[g], i)[j] = 0.0;
       }
     }
   }
@@ -142,35 +231,319 @@ static void initMatrices(struct calculation_arguments *arguments,
   if (options->inf_func == FUNC_F0) {
     for (g = 0; g < arguments->num_matrices; g++) {
       for (i = 0; i <= N; i++) {
-        Matrix[g][i][0] = 3 + (1 - (h * i)); // Linke Kante
-        Matrix[g][N][i] = 3 - (h * i);       // Untere Kante
-        Matrix[g][N - i][N] = 2 + h * i;     // Rechte Kante
-        Matrix[g][0][N - i] = 3 + h * i;     // Obere Kante
+        gridRow(&Matrix[g], i)[0] = 3 + (1 - (h * i)); // Linke Kante
+        gridRow(&Matrix[g], N)[i] = 3 - (h * i);       // Untere Kante
+        gridRow(&Matrix[g], N - i)[N] = 2 + h * i;     // Rechte Kante
+        gridRow(&Matrix[g], 0)[N - i] = 3 + h * i;     // Obere Kante
       }
     }
   }
 }
 
 /* ************************************************************************ */
-/* calculate: solves the equation                                           */
+/* initSourceTerm: tabulates the inference function                         */
+/*                                                                          */
+/* f(x,y) = 2pi^2*sin(pi*x)sin(pi*y) is separable, so the term              */
+/* fpisin * sin(pi*h*i) * sin(pi*h*j) added to every element is the         */
+/* product of a row and a column factor. Both are computed once here        */
+/* instead of calling sin() for every element in every iteration.           */
 /* ************************************************************************ */
-static void calculate(struct calculation_arguments const *arguments,
-                      struct calculation_results *results,
-                      struct options const *options) {
-  int i, j;           /* local variables for loops */
+static void initSourceTerm(struct calculation_arguments *arguments,
+                           struct options const *options) {
+  uint64_t i;
+
+  uint64_t const N = arguments->N;
+  double const h = arguments->h;
+
+  double const pih = PI * h;
+  double const fpisin = 0.25 * TWO_PI_SQUARE * h * h;
+
+  if (options->inf_func != FUNC_FPISIN) {
+    return;
+  }
+
+  arguments->fpisin_row = allocateMemory((N + 1) * sizeof(double));
+  arguments->sin_col = allocateMemory((N + 1) * sizeof(double));
+
+  for (i = 0; i <= N; i++) {
+    arguments->fpisin_row[i] = fpisin * sin(pih * (double)i);
+    arguments->sin_col[i] = sin(pih * (double)i);
+  }
+}
+
+/* ************************************************************************ */
+/* sweepRow: updates the elements first, first + step, ... < last of one    */
+/* row in place, in natural order                                           */
+/*                                                                          */
+/* step, source, check and relax are constants in each instance below, so   */
+/* the inference function, the residuum and the over-relaxation are only   */
+/* compiled into the loops that need them.                                  */
+/* ************************************************************************ */
+__attribute__((always_inline)) static inline double
+sweepRow(double *restrict row, double const *restrict above,
+         double const *restrict below, int first, int last, double fpisin_i,
+         double const *restrict sin_col, double omega, double maxResiduum,
+         int const step, int const source, int const check, int const relax) {
+  for (int j = first; j < last; j += step) {
+    double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+    if (source) {
+      star += fpisin_i * sin_col[j];
+    }
+
+    if (check) {
+      double residuum = row[j] - star;
+      residuum = (residuum < 0) ? -residuum : residuum;
+      maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+    }
+
+    /* over-relaxation; omega = 1 is plain Gauß-Seidel */
+    if (relax) {
+      star = row[j] + omega * (star - row[j]);
+    }
+
+    row[j] = star;
+  }
+
+  return maxResiduum;
+}
+
+typedef double (*row_kernel)(double *restrict, double const *restrict,
+                             double const *restrict, int, int, double,
+                             double const *restrict, double, double);
+
+#define ROW_KERNEL(step, source, check, relax)                                 \
+  static double sweepRow##step##source##check##relax(                          \
+      double *restrict row, double const *restrict above,                      \
+      double const *restrict below, int first, int last, double fpisin_i,      \
+      double const *restrict sin_col, double omega, double maxResiduum) {      \
+    return sweepRow(row, above, below, first, last, fpisin_i, sin_col, omega,  \
+                    maxResiduum, step, source, check, relax);                  \
+  }
+
+#define ROW_KERNELS(step)                                                      \
+  ROW_KERNEL(step, 0, 0, 0)                                                    \
+  ROW_KERNEL(step, 0, 0, 1)                                                    \
+  ROW_KERNEL(step, 0, 1, 0)                                                    \
+  ROW_KERNEL(step, 0, 1, 1)                                                    \
+  ROW_KERNEL(step, 1, 0, 0)                                                    \
+  ROW_KERNEL(step, 1, 0, 1)                                                    \
+  ROW_KERNEL(step, 1, 1, 0)                                                    \
+  ROW_KERNEL(step, 1, 1, 1)
+
+ROW_KERNELS(1)
+ROW_KERNELS(2)
+
+/* [step - 1][source][check][relax] */
+static row_kernel const rowKernels[2][2][2][2] = {
+    {{{sweepRow1000, sweepRow1001}, {sweepRow1010, sweepRow1011}},
+     {{sweepRow1100, sweepRow1101}, {sweepRow1110, sweepRow1111}}},
+    {{{sweepRow2000, sweepRow2001}, {sweepRow2010, sweepRow2011}},
+     {{sweepRow2100, sweepRow2101}, {sweepRow2110, sweepRow2111}}}};
+
+/* ************************************************************************ */
+/* selectRowKernel: returns the instance of sweepRow for every step-th      */
+/* element, the inference function given by sin_col, check and omega        */
+/* ************************************************************************ */
+static inline row_kernel selectRowKernel(int step, double const *sin_col,
+                                         int check, double omega) {
+  return rowKernels[step - 1][sin_col != NULL][check != 0][omega != 1.0];
+}
+
+/* ************************************************************************ */
+/* State of the band of rows of one thread in the asynchronous mode         */
+/* ************************************************************************ */
+struct band_state {
+  _Alignas(CACHE_LINE) _Atomic uint64_t sweeps; /* finished sweeps          */
+  _Atomic uint64_t seen[2]; /* sweeps of the bands above and below before   */
+                            /* the last checked sweep                       */
+  atomic_int converged;     /* residuum of the last checked sweep is small  */
+  double precision;         /* residuum of the last checked sweep           */
+};
+
+/* ************************************************************************ */
+/* loadRow, storeRow: copy a row that another thread accesses at the same   */
+/* time, element by element with relaxed atomics                            */
+/* ************************************************************************ */
+static inline void loadRow(double *dst, double *src, int N) {
+  for (int j = 0; j <= N; j++) {
+    __atomic_load(&src[j], &dst[j], __ATOMIC_RELAXED);
+  }
+}
+
+static inline void storeRow(double *dst, double *src, int N) {
+  for (int j = 1; j < N; j++) {
+    __atomic_store(&dst[j], &src[j], __ATOMIC_RELAXED);
+  }
+}
+
+/* ************************************************************************ */
+/* sweepBand: one Gauß-Seidel (SOR) sweep over the rows [i0, i1) without    */
+/* waiting for the neighbouring bands                                       */
+/*                                                                          */
+/* The first and the last row of the band are read by the neighbours, the   */
+/* rows next to the band are written by them. These four rows go through    */
+/* relaxed atomics and three line buffers; the rows inside the band are     */
+/* updated in place as usual.                                               */
+/* ************************************************************************ */
+static double sweepBand(struct calculation_arguments const *arguments, int i0,
+                        int i1, double *lines, double omega, int check) {
+  double maxResiduum = 0;
+
+  int const N = arguments->N;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  row_kernel const sweep = selectRowKernel(1, sin_col, check, omega);
+
+  double *above_band = lines;
+  double *below_band = lines + (N + 1);
+  double *line = lines + 2 * (N + 1);
+
+  loadRow(above_band, gridRow(Matrix, i0 - 1), N);
+
+  for (int i = i0; i < i1; i++) {
+    double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+    double const *above = (i == i0) ? above_band : gridRow(Matrix, i - 1);
+    double const *below = gridRow(Matrix, i + 1);
+
+    /* as late as possible, to see the newest values */
+    if (i == i1 - 1) {
+      loadRow(below_band, gridRow(Matrix, i1), N);
+      below = below_band;
+    }
+
+    if (i == i0 || i == i1 - 1) {
+      memcpy(line, gridRow(Matrix, i), (N + 1) * sizeof(double));
+
+      maxResiduum =
+          sweep(line, above, below, 1, N, fpisin_i, sin_col, omega, maxResiduum);
+
+      storeRow(gridRow(Matrix, i), line, N);
+    } else {
+      maxResiduum = sweep(gridRow(Matrix, i), above, below, 1, N, fpisin_i,
+                          sin_col, omega, maxResiduum);
+    }
+  }
+
+  return maxResiduum;
+}
+
+/* ************************************************************************ */
+/* bandsConverged: whether the last residuum of every band is small enough  */
+/*                                                                          */
+/* A band that computed its residuum long ago, against rows its neighbours  */
+/* have changed since, proves nothing: a thread that gets the CPU to itself */
+/* quickly converges its band to the frozen rows of the others. A residuum  */
+/* only counts if the neighbours have finished at most one sweep since,     */
+/* and that sweep changed their rows by less than term_precision.           */
+/* ************************************************************************ */
+static int bandsConverged(struct band_state *bands, int num_bands) {
+  for (int b = 0; b < num_bands; b++) {
+    if (!atomic_load_explicit(&bands[b].converged, memory_order_relaxed)) {
+      return 0;
+    }
+
+    for (int side = 0; side < 2; side++) {
+      int const n = (side == 0) ? b - 1 : b + 1;
+
+      if (n < 0 || n >= num_bands) {
+        continue;
+      }
+
+      if (atomic_load_explicit(&bands[n].sweeps, memory_order_relaxed) >
+          atomic_load_explicit(&bands[b].seen[side], memory_order_relaxed) +
+              1) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+/* ************************************************************************ */
+/* neighbourSweeps: finished sweeps of band n, 0 if there is no such band   */
+/* ************************************************************************ */
+static inline uint64_t neighbourSweeps(struct band_state *bands, int n,
+                                       int num_bands) {
+  if (n < 0 || n >= num_bands) {
+    return 0;
+  }
+
+  return atomic_load_explicit(&bands[n].sweeps, memory_order_relaxed);
+}
+
+/* ************************************************************************ */
+/* Data shared by all workers of one calculation                            */
+/* ************************************************************************ */
+struct residuum_slot {
+  _Alignas(CACHE_LINE) double value; /* maxResiduum of one worker            */
+};
+
+struct row_progress {
+  _Alignas(CACHE_LINE) _Atomic uint64_t done; /* finished iterations of a row */
+};
+
+struct calculation_shared {
+  struct calculation_arguments const *arguments;
+  struct calculation_results *results;
+  struct options const *options;
+  uint64_t num_threads;          /* number of workers                         */
+  pthread_barrier_t barrier;     /* end of an iteration                       */
+  struct residuum_slot *residuum; /* 2 * num_threads slots, one set per parity */
+  struct row_progress *progress; /* N + 1 counters, Gauß-Seidel only         */
+  struct band_state *bands;      /* one per worker, asynchronous mode only   */
+  atomic_int done;               /* asynchronous mode: all bands converged   */
+};
+
+struct calculation_worker {
+  pthread_t thread;
+  uint64_t id;
+  int first_row; /* first row of the band owned by the worker            */
+  int last_row;  /* first row after the band owned by the worker         */
+  struct calculation_shared *shared;
+};
+
+/* ************************************************************************ */
+/* calculateWorker: solves the equation on the rows of one worker           */
+/*                                                                          */
+/* Every worker keeps its band of rows for the whole calculation and syncs  */
+/* once per iteration. The residuum slots alternate between two sets, so    */
+/* the slots of iteration k are not overwritten before everyone read them.  */
+/* ************************************************************************ */
+static void *calculateWorker(void *arg) {
+  struct calculation_worker *worker = arg;
+  struct calculation_shared *shared = worker->shared;
+  struct calculation_arguments const *arguments = shared->arguments;
+  struct options const *options = shared->options;
+
+  int i;              /* local variables for loops */
   int m1, m2;         /* used as indices for old and new matrices */
-  double star;        /* four times center value minus 4 neigh.b values */
   double residuum;    /* residuum of current iteration */
   double maxResiduum; /* maximum residuum value of a slave in iteration */
+  uint64_t t;
+  uint64_t parity = 0;
+  uint64_t stat_iteration = 0;
 
   int const N = arguments->N;
-  double const h = arguments->h;
 
-  double pih = 0.0;
-  double fpisin = 0.0;
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
 
   int term_iteration = options->term_iteration;
 
+  double const omega = relaxationFactor(options);
+
+  jacobi_row_kernel const jacobiRow[2] = {
+      selectJacobiRowKernel(sin_col != NULL, 0),
+      selectJacobiRowKernel(sin_col != NULL, 1)};
+
+  /* element (i, j) and (i, j + 2) have the same color */
+  row_kernel const sweepRedBlack[2] = {selectRowKernel(2, sin_col, 0, omega),
+                                       selectRowKernel(2, sin_col, 1, omega)};
+
   /* initialize m1 and m2 depending on algorithm */
   if (options->method == METH_JACOBI) {
     m1 = 0;
@@ -180,46 +553,59 @@ static void calculate(struct calculation_arguments const *arguments,
     m2 = 0;
   }
 
-  if (options->inf_func == FUNC_FPISIN) {
-    pih = PI * h;
-    fpisin = 0.25 * TWO_PI_SQUARE * h * h;
-  }
+  maxResiduum = 0;
 
   while (term_iteration > 0) {
-    double **Matrix_Out = arguments->Matrix[m1];
-    double **Matrix_In = arguments->Matrix[m2];
+    struct grid const *Matrix_Out = &arguments->Matrix[m1];
+    struct grid const *Matrix_In = &arguments->Matrix[m2];
 
-    maxResiduum = 0;
+    int const check =
+        (options->termination == TERM_PREC || term_iteration == 1);
 
-    /* over all rows */
-    for (i = 1; i < N; i++) {
-      double fpisin_i = 0.0;
+    maxResiduum = 0;
 
-      if (options->inf_func == FUNC_FPISIN) {
-        fpisin_i = fpisin * sin(pih * (double)i);
-      }
+    if (options->method == METH_RED_BLACK ||
+        options->method == METH_SOR_RED_BLACK) {
+      /* element (i, j) is red if i + j is even; red before black */
+      for (int color = 0; color < 2; color++) {
+        if (color == 1) {
+          pthread_barrier_wait(&shared->barrier);
+        }
 
-      /* over all columns */
-      for (j = 1; j < N; j++) {
-        star = 0.25 * (Matrix_In[i - 1][j] + Matrix_In[i][j - 1] +
-                       Matrix_In[i][j + 1] + Matrix_In[i + 1][j]);
+        for (i = worker->first_row; i < worker->last_row; i++) {
+          double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
 
-        if (options->inf_func == FUNC_FPISIN) {
-          star += fpisin_i * sin(pih * (double)j);
+          maxResiduum = sweepRedBlack[check](
+              gridRow(Matrix_Out, i), gridRow(Matrix_Out, i - 1),
+              gridRow(Matrix_Out, i + 1), 1 + ((i + 1 + color) & 1), N,
+              fpisin_i, sin_col, omega, maxResiduum);
         }
+      }
+    } else {
+      /* over all rows of the band, each row as one vector kernel */
+      for (i = worker->first_row; i < worker->last_row; i++) {
+        double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+        maxResiduum = jacobiRow[check](
+            gridRow(Matrix_Out, i), gridRow(Matrix_In, i - 1),
+            gridRow(Matrix_In, i), gridRow(Matrix_In, i + 1), sin_col,
+            fpisin_i, N, maxResiduum);
+      }
+    }
 
-        if (options->termination == TERM_PREC || term_iteration == 1) {
-          residuum = Matrix_In[i][j] - star;
-          residuum = (residuum < 0) ? -residuum : residuum;
-          maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
-        }
+    shared->residuum[parity * shared->num_threads + worker->id].value =
+        maxResiduum;
 
-        Matrix_Out[i][j] = star;
-      }
+    pthread_barrier_wait(&shared->barrier);
+
+    /* every worker combines the slots and takes the same decision */
+    for (t = 0; t < shared->num_threads; t++) {
+      residuum = shared->residuum[parity * shared->num_threads + t].value;
+      maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
     }
 
-    results->stat_iteration++;
-    results->stat_precision = maxResiduum;
+    parity ^= 1;
+    stat_iteration++;
 
     /* exchange m1 and m2 */
     i = m1;
@@ -236,7 +622,338 @@ static void calculate(struct calculation_arguments const *arguments,
     }
   }
 
-  results->m = m2;
+  if (worker->id == 0) {
+    shared->results->stat_iteration = stat_iteration;
+    shared->results->stat_precision = maxResiduum;
+    shared->results->m = m2;
+  }
+
+  return NULL;
+}
+
+/* ************************************************************************ */
+/* waitForRow: waits until row has finished the given number of iterations  */
+/* ************************************************************************ */
+static void waitForRow(struct row_progress *progress, int row,
+                       uint64_t iteration) {
+  while (atomic_load_explicit(&progress[row].done, memory_order_acquire) <
+         iteration) {
+    sched_yield();
+  }
+}
+
+/* ************************************************************************ */
+/* calculateGaussSeidelWorker: solves the equation with the Gauß-Seidel     */
+/* or the SOR method on the rows of one worker                              */
+/*                                                                          */
+/* In iteration k row i needs row i-1 of iteration k and row i+1 of         */
+/* iteration k-1. Every row publishes the number of iterations it has       */
+/* finished, so a worker only waits for the last row of the band above and  */
+/* the first row of the band below. There is no barrier: while worker t     */
+/* is in iteration k, worker t-1 can already be in iteration k+1, and the   */
+/* results are identical to the sequential loop.                            */
+/*                                                                          */
+/* TERM_PREC needs the residuum of iteration k before iteration k+1 may     */
+/* start, which drains the pipeline in every iteration.                     */
+/* ************************************************************************ */
+static void *calculateGaussSeidelWorker(void *arg) {
+  struct calculation_worker *worker = arg;
+  struct calculation_shared *shared = worker->shared;
+  struct calculation_arguments const *arguments = shared->arguments;
+  struct options const *options = shared->options;
+  struct row_progress *progress = shared->progress;
+
+  int i;              /* local variable for loops */
+  double residuum;    /* residuum of current iteration */
+  double maxResiduum; /* maximum residuum value of a slave in iteration */
+  uint64_t t;
+  uint64_t iteration = 0;
+
+  int const N = arguments->N;
+
+  int term_iteration = options->term_iteration;
+
+  double const omega = relaxationFactor(options);
+
+  struct grid const *Matrix = &arguments->Matrix[0];
+
+  double const *fpisin_row = arguments->fpisin_row;
+  double const *sin_col = arguments->sin_col;
+
+  row_kernel const sweep[2] = {selectRowKernel(1, sin_col, 0, omega),
+                               selectRowKernel(1, sin_col, 1, omega)};
+
+  maxResiduum = 0;
+
+  while (term_iteration > 0) {
+    int const check =
+        (options->termination == TERM_PREC || term_iteration == 1);
+
+    iteration++;
+    maxResiduum = 0;
+
+    /* over all rows of the band */
+    for (i = worker->first_row; i < worker->last_row; i++) {
+      double const fpisin_i = (sin_col != NULL) ? fpisin_row[i] : 0.0;
+
+      if (i == worker->first_row) {
+        waitForRow(progress, i - 1, iteration);
+      }
+
+      if (i == worker->last_row - 1) {
+        waitForRow(progress, i + 1, iteration - 1);
+      }
+
+      double const *above = gridRow(Matrix, i - 1);
+      double *row = gridRow(Matrix, i);
+      double const *below = gridRow(Matrix, i + 1);
+
+      /* over all columns */
+      maxResiduum = sweep[check](row, above, below, 1, N, fpisin_i, sin_col,
+                                 omega, maxResiduum);
+
+      /* publish the residuum together with the last row of the band */
+      if (check && i == worker->last_row - 1) {
+        shared->residuum[(iteration & 1) * shared->num_threads + worker->id]
+            .value = maxResiduum;
+      }
+
+      atomic_store_explicit(&progress[i].done, iteration,
+                            memory_order_release);
+    }
+
+    /* once row N-1 is finished, all rows (and residua) are */
+    if (check) {
+      waitForRow(progress, N - 1, iteration);
+
+      for (t = 0; t < shared->num_threads; t++) {
+        residuum =
+            shared->residuum[(iteration & 1) * shared->num_threads + t].value;
+        maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+      }
+    }
+
+    /* check for stopping calculation depending on termination method */
+    if (options->termination == TERM_PREC) {
+      if (maxResiduum < options->term_precision) {
+        term_iteration = 0;
+      }
+    } else if (options->termination == TERM_ITER) {
+      term_iteration--;
+    }
+  }
+
+  if (worker->id == 0) {
+    shared->results->stat_iteration = iteration;
+    shared->results->stat_precision = maxResiduum;
+    shared->results->m = 0;
+  }
+
+  return NULL;
+}
+
+/* ************************************************************************ */
+/* calculateAsyncWorker: solves the equation with the Gauß-Seidel or the    */
+/* SOR method on the rows of one worker without barriers (asynchronous or   */
+/* chaotic relaxation)                                                      */
+/*                                                                          */
+/* The worker sweeps its band again and again with sweepBand(), reading     */
+/* the rows of its neighbours as they are at that moment. For this          */
+/* diagonally dominant problem the iteration converges all the same, and    */
+/* no worker ever waits for a slower one. With TERM_PREC, each band flags   */
+/* whether its last residuum is below term_precision; the first worker to   */
+/* find all flags set and recent (see bandsConverged()) ends the            */
+/* calculation. calculate() reports the highest number of sweeps of a band  */
+/* and the highest last residuum.                                           */
+/* ************************************************************************ */
+static void *calculateAsyncWorker(void *arg) {
+  struct calculation_worker *worker = arg;
+  struct calculation_shared *shared = worker->shared;
+  struct calculation_arguments const *arguments = shared->arguments;
+  struct options const *options = shared->options;
+  struct band_state *bands = shared->bands;
+
+  uint64_t sweeps = 0;
+
+  int const N = arguments->N;
+  int const b = worker->id;
+  int const num_bands = shared->num_threads;
+
+  double const omega = relaxationFactor(options);
+
+  double *lines = allocateMemory(3 * (N + 1) * sizeof(double));
+
+  while (1) {
+    uint64_t const above = neighbourSweeps(bands, b - 1, num_bands);
+    uint64_t const below = neighbourSweeps(bands, b + 1, num_bands);
+    double maxResiduum;
+    int check;
+
+    if (options->termination == TERM_ITER) {
+      if (sweeps == options->term_iteration) {
+        break;
+      }
+    } else if (atomic_load_explicit(&shared->done, memory_order_acquire)) {
+      break;
+    }
+
+    check = (options->termination == TERM_PREC ||
+             sweeps + 1 == options->term_iteration);
+    maxResiduum = sweepBand(arguments, worker->first_row, worker->last_row,
+                            lines, omega, check);
+    sweeps++;
+
+    if (check) {
+      bands[b].precision = maxResiduum;
+      atomic_store_explicit(&bands[b].seen[0], above, memory_order_relaxed);
+      atomic_store_explicit(&bands[b].seen[1], below, memory_order_relaxed);
+      atomic_store_explicit(&bands[b].converged,
+                            maxResiduum < options->term_precision,
+                            memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&bands[b].sweeps, sweeps, memory_order_relaxed);
+
+    if (options->termination == TERM_PREC &&
+        maxResiduum < options->term_precision &&
+        bandsConverged(bands, num_bands)) {
+      atomic_store_explicit(&shared->done, 1, memory_order_release);
+    }
+
+    /* with more workers than cores, let the neighbours catch up */
+    sched_yield();
+  }
+
+  free(lines);
+
+  return NULL;
+}
+
+/* ************************************************************************ */
+/* calculate: solves the equation                                           */
+/* ************************************************************************ */
+static void calculate(struct calculation_arguments const *arguments,
+                      struct calculation_results *results,
+                      struct options const *options) {
+  uint64_t t;
+
+  uint64_t const rows = arguments->N - 1;
+
+  struct calculation_shared shared;
+  struct calculation_worker *workers;
+  void *(*worker_main)(void *);
+
+  shared.arguments = arguments;
+  shared.results = results;
+  shared.options = options;
+  shared.num_threads = options->number;
+
+  if (shared.num_threads > rows) {
+    shared.num_threads = rows;
+  }
+
+  workers = allocateMemory(shared.num_threads * sizeof(*workers));
+  shared.residuum = aligned_alloc(
+      CACHE_LINE, 2 * shared.num_threads * sizeof(*shared.residuum));
+
+  if (shared.residuum == NULL) {
+    printf("Speicherprobleme!\n");
+    exit(1);
+  }
+
+  pthread_barrier_init(&shared.barrier, NULL, shared.num_threads);
+
+  shared.bands = NULL;
+  atomic_init(&shared.done, 0);
+
+  if (options->async &&
+      (options->method == METH_GAUSS_SEIDEL || options->method == METH_SOR)) {
+    worker_main = calculateAsyncWorker;
+    shared.progress = NULL;
+    shared.bands =
+        aligned_alloc(CACHE_LINE, shared.num_threads * sizeof(*shared.bands));
+
+    if (shared.bands == NULL) {
+      printf("Speicherprobleme!\n");
+      exit(1);
+    }
+
+    for (t = 0; t < shared.num_threads; t++) {
+      shared.bands[t].precision = 0;
+      atomic_init(&shared.bands[t].sweeps, 0);
+      atomic_init(&shared.bands[t].seen[0], 0);
+      atomic_init(&shared.bands[t].seen[1], 0);
+      atomic_init(&shared.bands[t].converged, 0);
+    }
+  } else if (options->method == METH_GAUSS_SEIDEL ||
+             options->method == METH_SOR) {
+    worker_main = calculateGaussSeidelWorker;
+    shared.progress = aligned_alloc(
+        CACHE_LINE, (arguments->N + 1) * sizeof(*shared.progress));
+
+    if (shared.progress == NULL) {
+      printf("Speicherprobleme!\n");
+      exit(1);
+    }
+
+    /* the border rows never change */
+    for (t = 0; t <= arguments->N; t++) {
+      atomic_init(&shared.progress[t].done, 0);
+    }
+
+    atomic_init(&shared.progress[0].done, UINT64_MAX);
+    atomic_init(&shared.progress[arguments->N].done, UINT64_MAX);
+  } else {
+    worker_main = calculateWorker;
+    shared.progress = NULL;
+  }
+
+  for (t = 0; t < shared.num_threads; t++) {
+    workers[t].id = t;
+    workers[t].first_row = 1 + (t * rows) / shared.num_threads;
+    workers[t].last_row = 1 + ((t + 1) * rows) / shared.num_threads;
+    workers[t].shared = &shared;
+  }
+
+  /* the main thread works as worker 0 */
+  for (t = 1; t < shared.num_threads; t++) {
+    if (pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]) !=
+        0) {
+      printf("Threads konnten nicht erzeugt werden!\n");
+      exit(1);
+    }
+  }
+
+  worker_main(&workers[0]);
+
+  for (t = 1; t < shared.num_threads; t++) {
+    pthread_join(workers[t].thread, NULL);
+  }
+
+  pthread_barrier_destroy(&shared.barrier);
+
+  if (shared.bands != NULL) {
+    results->stat_iteration = 0;
+    results->stat_precision = 0;
+    results->m = 0;
+
+    for (t = 0; t < shared.num_threads; t++) {
+      uint64_t const sweeps = atomic_load(&shared.bands[t].sweeps);
+
+      if (sweeps > results->stat_iteration) {
+        results->stat_iteration = sweeps;
+      }
+
+      if (shared.bands[t].precision > results->stat_precision) {
+        results->stat_precision = shared.bands[t].precision;
+      }
+    }
+  }
+
+  free(shared.bands);
+  free(shared.progress);
+  free(shared.residuum);
+  free(workers);
 }
 
 /* ************************************************************************ */
@@ -245,20 +962,23 @@ static void calculate(struct calculation_arguments const *arguments,
 static void displayStatistics(struct calculation_arguments const *arguments,
                               struct calculation_results const *results,
                               struct options const *options) {
-  int N = arguments->N;
   double time = (comp_time.tv_sec - start_time.tv_sec) +
                 (comp_time.tv_usec - start_time.tv_usec) * 1e-6;
 
   printf("Berechnungszeit:    %f s \n", time);
-  printf("Speicherbedarf:     %f MiB\n", (N + 1) * (N + 1) * sizeof(double) *
-                                             arguments->num_matrices / 1024.0 /
-                                             1024.0);
+  printf("Speicherbedarf:     %f MiB\n", arguments->M_size / 1024.0 / 1024.0);
   printf("Berechnungsmethode: ");
 
   if (options->method == METH_GAUSS_SEIDEL) {
     printf("Gauß-Seidel");
   } else if (options->method == METH_JACOBI) {
     printf("Jacobi");
+  } else if (options->method == METH_RED_BLACK) {
+    printf("Gauß-Seidel (rot-schwarz)");
+  } else if (options->method == METH_SOR) {
+    printf("SOR (omega = %f)", options->omega);
+  } else if (options->method == METH_SOR_RED_BLACK) {
+    printf("SOR (rot-schwarz, omega = %f)", options->omega);
   }
 
   printf("\n");
@@ -301,7 +1021,7 @@ static void displayMatrix(struct calculation_arguments *arguments,
                           struct options *options) {
   int x, y;
 
-  double **Matrix = arguments->Matrix[results->m];
+  struct grid const *Matrix = &arguments->Matrix[results->m];
 
   int const interlines = options->interlines;
 
@@ -309,7 +1029,7 @@ static void displayMatrix(struct calculation_arguments *arguments,
 
   for (y = 0; y < 9; y++) {
     for (x = 0; x < 9; x++) {
-      printf("%11.8f", Matrix[y * (interlines + 1)][x * (interlines + 1)]);
+      printf("%11.8f", gridRow(Matrix, y * (interlines + 1))[x * (interlines + 1)]);
     }
 
     printf("\n");
@@ -330,8 +1050,9 @@ int main(int argc, char **argv) {
 
   initVariables(&arguments, &results, &options);
 
-  allocateMatrices(&arguments);
+  allocateMatrices(&arguments, &options);
   initMatrices(&arguments, &options);
+  initSourceTerm(&arguments, &options);
 
   gettimeofday(&start_time, NULL);
   calculate(&arguments, &results, &options);
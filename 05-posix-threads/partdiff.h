@@ -27,12 +27,20 @@
 #define MAX_INTERLINES 10240
 #define MAX_ITERATION 200000
 #define MAX_THREADS 1024
+#define CACHE_LINE 64
 #define METH_GAUSS_SEIDEL 1
 #define METH_JACOBI 2
+#define METH_RED_BLACK 3
+#define METH_SOR 4
+#define METH_SOR_RED_BLACK 5
 #define FUNC_F0 1
 #define FUNC_FPISIN 2
 #define TERM_PREC 1
 #define TERM_ITER 2
+#define HUGE_PAGES_OFF 0
+#define HUGE_PAGES_TRANSPARENT 1
+#define HUGE_PAGES_EXPLICIT 2
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 struct options {
   uint64_t number;         /* Number of threads                              */
@@ -42,13 +50,26 @@ struct options {
   uint64_t termination;    /* termination condition                          */
   uint64_t term_iteration; /* terminate if iteration number reached          */
   double term_precision;   /* terminate if precision reached                 */
+  uint64_t huge_pages;     /* huge pages for matrices (PARTDIFF_HUGEPAGES)   */
+  double omega;            /* relaxation factor of SOR (PARTDIFF_OMEGA)      */
+  uint64_t async;          /* barrier-free Gauß-Seidel (PARTDIFF_ASYNC)      */
 };
 
+/* Kernel computing one row of the Jacobi method, see stencil.c */
+typedef double (*jacobi_row_kernel)(double *restrict, double const *restrict,
+                                    double const *restrict,
+                                    double const *restrict,
+                                    double const *restrict, double, int,
+                                    double);
+
 /* *************************** */
 /* Some function declarations. */
 /* *************************** */
 /* Documentation in files      */
 /* - askparams.c               */
 /* - displaymatrix.c           */
+/* - stencil.c                 */
 /* *************************** */
 void askParams(struct options *, int, char **);
+
+jacobi_row_kernel selectJacobiRowKernel(int, int);
@@ -0,0 +1,250 @@
+/****************************************************************************/
+/****************************************************************************/
+/**                                                                        **/
+/**                 TU München - Institut für Informatik                   **/
+/**                                                                        **/
+/** File:      stencil.c                                                   **/
+/**                                                                        **/
+/** Purpose:   Vectorized row kernels for the Jacobi method (SSE2, AVX2,   **/
+/**            AVX-512 and a scalar fallback), selected at runtime.        **/
+/**                                                                        **/
+/****************************************************************************/
+/****************************************************************************/
+
+/****************************************************************************/
+/** Beschreibung der Kernel:                                               **/
+/**                                                                        **/
+/** Jeder Kernel berechnet eine Zeile der neuen Matrix                     **/
+/**                                                                        **/
+/**   out[j] = 0.25 * (above[j] + row[j-1] + row[j+1] + below[j])          **/
+/**                                                                        **/
+/** f"ur 1 <= j < N und liefert, falls check gesetzt ist, das Maximum von  **/
+/** maxResiduum und |row[j] - out[j]| zur"uck. Ist source gesetzt, wird    **/
+/** zus"atzlich die St"orfunktion fpisin_i * sin_col[j] addiert.           **/
+/** Die Summanden werden in derselben Reihenfolge wie in der skalaren      **/
+/** Schleife addiert, die Ergebnisse sind also bitgleich.                  **/
+/**                                                                        **/
+/** source und check sind Konstanten: f"ur jeden Befehlssatz wird jede     **/
+/** der vier Kombinationen als eigene Funktion ohne Verzweigungen in der   **/
+/** Schleife erzeugt, selectJacobiRowKernel() w"ahlt sie einmal aus.       **/
+/****************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "partdiff.h"
+
+/* parameters of all kernels, and the instances of a kernel template */
+#define JACOBI_ROW_PARAMS                                                      \
+  double *restrict out, double const *restrict above,                          \
+      double const *restrict row, double const *restrict below,                \
+      double const *restrict sin_col, double fpisin_i, int N,                  \
+      double maxResiduum
+
+#define JACOBI_ROW_INSTANCE(attributes, isa, source, check)                    \
+  attributes static double jacobiRow##isa##_##source##check(                   \
+      JACOBI_ROW_PARAMS) {                                                     \
+    return jacobiRow##isa(out, above, row, below, sin_col, fpisin_i, N,        \
+                          maxResiduum, source, check);                         \
+  }
+
+#define JACOBI_ROW_INSTANCES(attributes, isa)                                  \
+  JACOBI_ROW_INSTANCE(attributes, isa, 0, 0)                                   \
+  JACOBI_ROW_INSTANCE(attributes, isa, 0, 1)                                   \
+  JACOBI_ROW_INSTANCE(attributes, isa, 1, 0)                                   \
+  JACOBI_ROW_INSTANCE(attributes, isa, 1, 1)                                   \
+                                                                               \
+  static jacobi_row_kernel const jacobiRow##isa##Kernels[2][2] = {             \
+      {jacobiRow##isa##_00, jacobiRow##isa##_01},                              \
+      {jacobiRow##isa##_10, jacobiRow##isa##_11}};
+
+__attribute__((always_inline)) static inline double
+jacobiRowScalar(double *restrict out, double const *restrict above,
+                double const *restrict row, double const *restrict below,
+                double const *restrict sin_col, double fpisin_i, int N,
+                double maxResiduum, int const source, int const check) {
+  for (int j = 1; j < N; j++) {
+    double star = 0.25 * (above[j] + row[j - 1] + row[j + 1] + below[j]);
+
+    if (source) {
+      star += fpisin_i * sin_col[j];
+    }
+
+    if (check) {
+      double residuum = row[j] - star;
+      residuum = (residuum < 0) ? -residuum : residuum;
+      maxResiduum = (residuum < maxResiduum) ? maxResiduum : residuum;
+    }
+
+    out[j] = star;
+  }
+
+  return maxResiduum;
+}
+
+JACOBI_ROW_INSTANCES(, Scalar)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2"), always_inline)) static inline double
+jacobiRowSSE2(double *restrict out, double const *restrict above,
+              double const *restrict row, double const *restrict below,
+              double const *restrict sin_col, double fpisin_i, int N,
+              double maxResiduum, int const source, int const check) {
+  __m128d const quarter = _mm_set1_pd(0.25);
+  __m128d const sign = _mm_set1_pd(-0.0);
+  __m128d const fpisin = _mm_set1_pd(fpisin_i);
+  __m128d max = _mm_set1_pd(maxResiduum);
+  double tmp[2];
+  int j;
+
+  for (j = 1; j + 2 <= N; j += 2) {
+    __m128d sum = _mm_add_pd(_mm_loadu_pd(above + j), _mm_loadu_pd(row + j - 1));
+    sum = _mm_add_pd(sum, _mm_loadu_pd(row + j + 1));
+    sum = _mm_add_pd(sum, _mm_loadu_pd(below + j));
+    __m128d star = _mm_mul_pd(quarter, sum);
+
+    if (source) {
+      star = _mm_add_pd(star, _mm_mul_pd(fpisin, _mm_loadu_pd(sin_col + j)));
+    }
+
+    if (check) {
+      __m128d residuum = _mm_sub_pd(_mm_loadu_pd(row + j), star);
+      max = _mm_max_pd(max, _mm_andnot_pd(sign, residuum));
+    }
+
+    _mm_storeu_pd(out + j, star);
+  }
+
+  _mm_storeu_pd(tmp, max);
+  maxResiduum = (tmp[0] < tmp[1]) ? tmp[1] : tmp[0];
+
+  /* remainder */
+  return jacobiRowScalar(out + j - 1, above + j - 1, row + j - 1,
+                         below + j - 1, source ? sin_col + j - 1 : NULL,
+                         fpisin_i, N - j + 1, maxResiduum, source, check);
+}
+
+JACOBI_ROW_INSTANCES(__attribute__((target("sse2"))), SSE2)
+
+__attribute__((target("avx2"), always_inline)) static inline double
+jacobiRowAVX2(double *restrict out, double const *restrict above,
+              double const *restrict row, double const *restrict below,
+              double const *restrict sin_col, double fpisin_i, int N,
+              double maxResiduum, int const source, int const check) {
+  __m256d const quarter = _mm256_set1_pd(0.25);
+  __m256d const sign = _mm256_set1_pd(-0.0);
+  __m256d const fpisin = _mm256_set1_pd(fpisin_i);
+  __m256d max = _mm256_set1_pd(maxResiduum);
+  double tmp[4];
+  int j;
+
+  for (j = 1; j + 4 <= N; j += 4) {
+    __m256d sum =
+        _mm256_add_pd(_mm256_loadu_pd(above + j), _mm256_loadu_pd(row + j - 1));
+    sum = _mm256_add_pd(sum, _mm256_loadu_pd(row + j + 1));
+    sum = _mm256_add_pd(sum, _mm256_loadu_pd(below + j));
+    __m256d star = _mm256_mul_pd(quarter, sum);
+
+    if (source) {
+      star = _mm256_add_pd(
+          star, _mm256_mul_pd(fpisin, _mm256_loadu_pd(sin_col + j)));
+    }
+
+    if (check) {
+      __m256d residuum = _mm256_sub_pd(_mm256_loadu_pd(row + j), star);
+      max = _mm256_max_pd(max, _mm256_andnot_pd(sign, residuum));
+    }
+
+    _mm256_storeu_pd(out + j, star);
+  }
+
+  _mm256_storeu_pd(tmp, max);
+
+  for (int k = 0; k < 4; k++) {
+    maxResiduum = (tmp[k] < maxResiduum) ? maxResiduum : tmp[k];
+  }
+
+  /* remainder */
+  return jacobiRowScalar(out + j - 1, above + j - 1, row + j - 1,
+                         below + j - 1, source ? sin_col + j - 1 : NULL,
+                         fpisin_i, N - j + 1, maxResiduum, source, check);
+}
+
+JACOBI_ROW_INSTANCES(__attribute__((target("avx2"))), AVX2)
+
+__attribute__((target("avx512f"), always_inline)) static inline double
+jacobiRowAVX512(double *restrict out, double const *restrict above,
+                double const *restrict row, double const *restrict below,
+                double const *restrict sin_col, double fpisin_i, int N,
+                double maxResiduum, int const source, int const check) {
+  __m512d const quarter = _mm512_set1_pd(0.25);
+  __m512d const fpisin = _mm512_set1_pd(fpisin_i);
+  __m512d max = _mm512_set1_pd(maxResiduum);
+  int j;
+
+  for (j = 1; j < N; j += 8) {
+    /* the last vector is masked instead of handled by a scalar loop */
+    __mmask8 const mask = (N - j >= 8) ? 0xff : (__mmask8)((1u << (N - j)) - 1);
+
+    __m512d sum = _mm512_add_pd(_mm512_maskz_loadu_pd(mask, above + j),
+                                _mm512_maskz_loadu_pd(mask, row + j - 1));
+    sum = _mm512_add_pd(sum, _mm512_maskz_loadu_pd(mask, row + j + 1));
+    sum = _mm512_add_pd(sum, _mm512_maskz_loadu_pd(mask, below + j));
+    __m512d star = _mm512_mul_pd(quarter, sum);
+
+    if (source) {
+      star = _mm512_add_pd(
+          star,
+          _mm512_mul_pd(fpisin, _mm512_maskz_loadu_pd(mask, sin_col + j)));
+    }
+
+    if (check) {
+      __m512d residuum =
+          _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, row + j), star);
+      max = _mm512_mask_max_pd(max, mask, max, _mm512_abs_pd(residuum));
+    }
+
+    _mm512_mask_storeu_pd(out + j, mask, star);
+  }
+
+  return _mm512_reduce_max_pd(max);
+}
+
+JACOBI_ROW_INSTANCES(__attribute__((target("avx512f"))), AVX512)
+
+#endif
+
+/* ************************************************************************ */
+/* selectJacobiRowKernel: returns the widest kernel the CPU supports, for   */
+/* rows with (source) or without the inference function and with (check)   */
+/* or without residuum                                                      */
+/* ************************************************************************ */
+jacobi_row_kernel selectJacobiRowKernel(int source, int check) {
+  source = (source != 0);
+  check = (check != 0);
+
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f")) {
+    return jacobiRowAVX512Kernels[source][check];
+  }
+
+  if (__builtin_cpu_supports("avx2")) {
+    return jacobiRowAVX2Kernels[source][check];
+  }
+
+  if (__builtin_cpu_supports("sse2")) {
+    return jacobiRowSSE2Kernels[source][check];
+  }
+#endif
+
+  return jacobiRowScalarKernels[source][check];
+}